@@ -0,0 +1,240 @@
+/**
+ * @file agenda.cpp
+ * @author Daniel Quadros
+ * @brief Agenda semanal dos set points
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * A agenda é gravada na EEPROM em cópias alternadas (copias.h); os
+ * dados são AGENDA_MAX entradas de 32 bits. Cada entrada tem, a partir do bit menos significativo, os dias
+ * (7 bits), o horário em minutos (11 bits) e os set points "liga" e
+ * "desliga" (7 bits cada).
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "agenda.h"
+#include "copias.h"
+
+// Identificação das cópias da agenda
+#define MAGICA  0x41474E21u
+
+static_assert(COPIA_TAM(AGENDA_MAX*sizeof(uint32_t)) <= AGENDA_TAM_COPIA,
+              "agenda grande demais para AGENDA_TAM_COPIA");
+
+// Conjuntos de dias pré definidos, na ordem apresentada na configuração
+static const uint8_t diasPre[] = {
+    AGENDA_TODOS, AGENDA_UTEIS, AGENDA_FIMSEM,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40,
+    0
+};
+static const char *nomeDiasPre[] = {
+    "Todos", "Seg-Sex", "Sab-Dom",
+    "Dom", "Seg", "Ter", "Qua", "Qui", "Sex", "Sab",
+    "Desativada"
+};
+#define N_DIAS_PRE (int) (sizeof(diasPre)/sizeof(diasPre[0]))
+
+// Agenda vazia (todas as entradas desativadas)
+void agendaPadrao (AGENDA *ag) {
+    for (int i = 0; i < AGENDA_MAX; i++) {
+        ag->ent[i].dias = 0;
+        ag->ent[i].minuto = 0;
+        ag->ent[i].liga = 20;
+        ag->ent[i].desliga = 25;
+    }
+}
+
+// Valida uma entrada (as mesmas restrições dos set points)
+bool agendaValida (const ENTRADA_AGENDA *ent) {
+    return (ent->dias <= AGENDA_TODOS) && (ent->minuto < MIN_DIA) &&
+           (ent->liga >= 0) && (ent->desliga <= 99) && (ent->liga < ent->desliga);
+}
+
+// Monta a tabela de transições
+// A ordenação é por inserção, mantendo a ordem das entradas: com duas
+// transições no mesmo horário, vale a da última entrada
+void agendaCompila (const AGENDA *ag, TABELA_AGENDA *tab) {
+    tab->n = 0;
+    tab->cursor = 0;
+    tab->minAnt = -1;
+    for (int i = 0; i < AGENDA_MAX; i++) {
+        const ENTRADA_AGENDA *e = &ag->ent[i];
+        if ((e->dias == 0) || !agendaValida(e)) {
+            continue;
+        }
+        for (int dia = 0; dia < 7; dia++) {
+            if ((e->dias & (1 << dia)) == 0) {
+                continue;
+            }
+            TRANSICAO t;
+            t.minSemana = (uint16_t) (dia*MIN_DIA + e->minuto);
+            t.liga = e->liga;
+            t.desliga = e->desliga;
+            int j = tab->n++;
+            while ((j > 0) && (tab->trans[j-1].minSemana > t.minSemana)) {
+                tab->trans[j] = tab->trans[j-1];
+                j--;
+            }
+            tab->trans[j] = t;
+        }
+    }
+}
+
+// Consulta a tabela no minuto da semana indicado
+bool agendaPasso (TABELA_AGENDA *tab, int minSemana, int *liga, int *desliga) {
+    if ((tab->n == 0) || (minSemana < 0)) {
+        tab->minAnt = -1;
+        return false;
+    }
+    if (minSemana == tab->minAnt) {
+        return false;           // caso normal: o minuto não mudou
+    }
+
+    bool mudou = false;
+    int passo = (minSemana - tab->minAnt + MIN_SEMANA) % MIN_SEMANA;
+    if ((tab->minAnt < 0) || (passo != 1)) {
+        // Primeira consulta ou salto do relógio (acerto para frente ou
+        // para trás): procura a transição em vigor. Na primeira consulta
+        // só posiciona o cursor (vale o que já estava em uso); num salto
+        // aplica se for outra ou se o salto parou exatamente no seu
+        // horário
+        // Antes da primeira transição da semana vale a última da
+        // semana anterior
+        int i = -1;
+        while (((i+1) < tab->n) && (tab->trans[i+1].minSemana <= minSemana)) {
+            i++;
+        }
+        if (i < 0) {
+            i = tab->n-1;
+        }
+        mudou = (tab->minAnt >= 0) &&
+                ((i != tab->cursor) || (tab->trans[i].minSemana == minSemana));
+        tab->cursor = i;
+    } else {
+        // Minuto seguinte (inclusive na virada da semana): o cursor anda
+        // pelas transições deste minuto, que são as seguintes à em vigor
+        // (circularmente); com várias no mesmo minuto vale a última
+        int i = (tab->cursor + 1) % tab->n;
+        for (int k = 0; (k < tab->n) && (tab->trans[i].minSemana == minSemana); k++) {
+            tab->cursor = i;
+            mudou = true;
+            i = (i + 1) % tab->n;
+        }
+    }
+    tab->minAnt = minSemana;
+    if (mudou) {
+        *liga = tab->trans[tab->cursor].liga;
+        *desliga = tab->trans[tab->cursor].desliga;
+    }
+    return mudou;
+}
+
+// Próxima transição depois da em vigor
+bool agendaProxima (const TABELA_AGENDA *tab, TRANSICAO *prox) {
+    if ((tab->n == 0) || (tab->minAnt < 0)) {
+        return false;
+    }
+    *prox = tab->trans[(tab->cursor + 1) % tab->n];
+    return true;
+}
+
+// Nome de um conjunto de dias
+const char *agendaNomeDias (uint8_t dias) {
+    for (int i = 0; i < N_DIAS_PRE; i++) {
+        if (diasPre[i] == dias) {
+            return nomeDiasPre[i];
+        }
+    }
+    return "Varios";
+}
+
+// Converte dias do formato texto ("-xxxxx-" = segunda a sexta)
+bool agendaLeDias (const char *txt, uint8_t *dias) {
+    if (strlen(txt) != 7) {
+        return false;
+    }
+    *dias = 0;
+    for (int i = 0; i < 7; i++) {
+        if (txt[i] == 'x') {
+            *dias |= 1 << i;
+        } else if (txt[i] != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Converte dias para o formato texto, txt deve ter espaço para 8 bytes
+void agendaEscreveDias (uint8_t dias, char *txt) {
+    for (int i = 0; i < 7; i++) {
+        txt[i] = (dias & (1 << i)) ? 'x' : '-';
+    }
+    txt[7] = 0;
+}
+
+// Próximo (delta = 1) ou anterior (delta = -1) conjunto pré definido
+// Um conjunto que não é pré definido vai para o primeiro ou o último
+uint8_t agendaProxDias (uint8_t dias, int delta) {
+    int i = (delta > 0) ? -1 : N_DIAS_PRE;
+    for (int j = 0; j < N_DIAS_PRE; j++) {
+        if (diasPre[j] == dias) {
+            i = j;
+            break;
+        }
+    }
+    return diasPre[(i + delta + N_DIAS_PRE) % N_DIAS_PRE];
+}
+
+// Nome do dia da semana
+const char *agendaNomeDia (int dia) {
+    static const char *nomes[] = { "Dom", "Seg", "Ter", "Qua", "Qui", "Sex", "Sab" };
+    return ((dia >= 0) && (dia < 7)) ? nomes[dia] : "???";
+}
+
+// Codificação de uma entrada em 32 bits
+static uint32_t codifica (const ENTRADA_AGENDA *e) {
+    return ((uint32_t) e->dias & 0x7F) |
+           (((uint32_t) e->minuto & 0x7FF) << 7) |
+           (((uint32_t) e->liga & 0x7F) << 18) |
+           (((uint32_t) e->desliga & 0x7F) << 25);
+}
+
+static void decodifica (uint32_t cod, ENTRADA_AGENDA *e) {
+    e->dias = cod & 0x7F;
+    e->minuto = (cod >> 7) & 0x7FF;
+    e->liga = (cod >> 18) & 0x7F;
+    e->desliga = (cod >> 25) & 0x7F;
+}
+
+// Carrega a agenda da cópia mais recente válida
+// Entradas inválidas ficam desativadas
+bool agendaCarrega (AGENDA *ag, uint32_t base, uint32_t *seq) {
+    uint32_t cod[AGENDA_MAX];
+
+    agendaPadrao (ag);
+    if (!copiasCarrega (MAGICA, cod, sizeof(cod), base, AGENDA_TAM_COPIA, seq)) {
+        return false;
+    }
+    for (int i = 0; i < AGENDA_MAX; i++) {
+        ENTRADA_AGENDA e;
+        decodifica (cod[i], &e);
+        if (agendaValida (&e)) {
+            ag->ent[i] = e;
+        }
+    }
+    return true;
+}
+
+// Grava a agenda na cópia mais antiga, seq é atualizado
+bool agendaGrava (const AGENDA *ag, uint32_t base, uint32_t *seq) {
+    uint32_t cod[AGENDA_MAX];
+
+    for (int i = 0; i < AGENDA_MAX; i++) {
+        cod[i] = codifica (&ag->ent[i]);
+    }
+    return copiasGrava (MAGICA, cod, sizeof(cod), base, AGENDA_TAM_COPIA, seq);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file agenda.h
+ * @author Daniel Quadros
+ * @brief Agenda semanal dos set points
+ *        Não depende do SDK, é usada também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * A agenda tem até AGENDA_MAX entradas; cada uma indica os dias da
+ * semana, o horário e os set points que passam a valer. Na EEPROM
+ * cada entrada ocupa 32 bits.
+ *
+ * Ao carregar (ou alterar) a agenda ela é compilada numa tabela com
+ * todas as transições da semana, em ordem de horário. A consulta a
+ * cada passo do controle mantém um cursor na transição em vigor: se o
+ * minuto não mudou basta uma comparação e, a cada minuto (inclusive
+ * na virada da semana), o cursor anda só pelas transições daquele
+ * minuto. Quando o minuto salta (acerto do relógio, para frente ou
+ * para trás) a posição é procurada de novo.
+ *
+ * Quando uma transição entra em vigor seus set points substituem os
+ * atuais; uma alteração manual vale até a próxima transição. A
+ * primeira consulta (na partida, depois de acertar o relógio pela
+ * primeira vez ou de alterar a agenda) só posiciona o cursor, sem
+ * aplicar a transição em vigor.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef AGENDA_H
+#define AGENDA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AGENDA_MAX      8               // entradas na agenda
+#define AGENDA_MAX_TRANS (AGENDA_MAX*7) // transições na semana
+#define AGENDA_TAM_COPIA 64             // espaço de cada cópia na EEPROM
+
+#define MIN_DIA     1440
+#define MIN_SEMANA  (7*MIN_DIA)
+
+// Dias da semana (bit 0 = domingo, como o dotw do RTC)
+#define AGENDA_TODOS    0x7F
+#define AGENDA_UTEIS    0x3E
+#define AGENDA_FIMSEM   0x41
+
+// Uma entrada da agenda
+typedef struct {
+    uint8_t dias;           // dias em que vale (0 = entrada desativada)
+    uint16_t minuto;        // horário (minutos desde a meia noite)
+    int8_t liga;            // set points (graus)
+    int8_t desliga;
+} ENTRADA_AGENDA;
+
+typedef struct {
+    ENTRADA_AGENDA ent[AGENDA_MAX];
+} AGENDA;
+
+// Uma transição da tabela compilada
+typedef struct {
+    uint16_t minSemana;     // minutos desde o início do domingo
+    int8_t liga;
+    int8_t desliga;
+} TRANSICAO;
+
+// Tabela compilada, consultada a cada passo do controle
+typedef struct {
+    TRANSICAO trans[AGENDA_MAX_TRANS];
+    int n;                  // número de transições
+    int cursor;             // transição em vigor
+    int minAnt;             // minuto da consulta anterior (-1 se nenhuma)
+} TABELA_AGENDA;
+
+// Funções fornecidas pela aplicação para acesso à EEPROM
+// (as mesmas usadas pela configuração)
+bool appEepromLe (uint8_t *buffer, uint32_t addr, int n);
+bool appEepromGrava (const uint8_t *buffer, uint32_t addr, int n);
+
+// Agenda vazia (todas as entradas desativadas)
+void agendaPadrao (AGENDA *ag);
+
+// Monta a tabela de transições
+// A próxima consulta posiciona o cursor sem aplicar nenhuma transição
+void agendaCompila (const AGENDA *ag, TABELA_AGENDA *tab);
+
+// Consulta a tabela no minuto da semana indicado (-1 se o relógio não
+// está acertado). Retorna true se outra transição entrou em vigor,
+// com os seus set points em liga e desliga
+bool agendaPasso (TABELA_AGENDA *tab, int minSemana, int *liga, int *desliga);
+
+// Próxima transição depois da em vigor, retorna false se não tiver
+bool agendaProxima (const TABELA_AGENDA *tab, TRANSICAO *prox);
+
+// Valida uma entrada
+bool agendaValida (const ENTRADA_AGENDA *ent);
+
+// Dias da semana: nome, conversão de/para texto ("x" se vale, "-" se
+// não, começando no domingo) e passagem para o próximo conjunto pré
+// definido (todos, úteis, fim de semana, cada dia, desativada)
+const char *agendaNomeDias (uint8_t dias);
+bool agendaLeDias (const char *txt, uint8_t *dias);
+void agendaEscreveDias (uint8_t dias, char *txt);
+uint8_t agendaProxDias (uint8_t dias, int delta);
+
+// Nome do dia da semana (0 = domingo)
+const char *agendaNomeDia (int dia);
+
+// Carrega a agenda da cópia mais recente válida em base e
+// base+AGENDA_TAM_COPIA. Retorna false (e agenda vazia) se não tiver
+bool agendaCarrega (AGENDA *ag, uint32_t base, uint32_t *seq);
+
+// Grava a agenda na cópia mais antiga, seq é atualizado
+bool agendaGrava (const AGENDA *ag, uint32_t base, uint32_t *seq);
+
+#endif
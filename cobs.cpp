@@ -0,0 +1,110 @@
+/**
+ * @file cobs.cpp
+ * @author Daniel Quadros
+ * @brief Montagem dos quadros de telemetria (COBS + CRC-8)
+ *        Não depende do SDK, é usado também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * COBS (Consistent Overhead Byte Stuffing) elimina os zeros do
+ * registro, com no máximo um byte a mais a cada 254, permitindo
+ * usar o zero como separador entre quadros.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "telemetria.h"
+
+// CRC-8 (polinômio 0x07)
+uint8_t crc8 (const uint8_t *p, int n) {
+    uint8_t crc = 0;
+    while (n--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Codificação COBS, retorna o tamanho codificado (sem terminador)
+int cobsCodifica (uint8_t *dest, const uint8_t *orig, int n) {
+    uint8_t *pCod = dest;       // onde vai o código do bloco atual
+    uint8_t cod = 1;
+    int tam = 1;
+
+    for (int i = 0; i < n; i++) {
+        if (orig[i] == 0) {
+            *pCod = cod;
+            pCod = &dest[tam++];
+            cod = 1;
+        } else {
+            dest[tam++] = orig[i];
+            if (++cod == 0xFF) {
+                *pCod = cod;
+                pCod = &dest[tam++];
+                cod = 1;
+            }
+        }
+    }
+    *pCod = cod;
+    return tam;
+}
+
+// Decodificação COBS, retorna o tamanho decodificado ou -1 se inválido
+int cobsDecodifica (uint8_t *dest, const uint8_t *orig, int n) {
+    int tam = 0;
+    int i = 0;
+
+    while (i < n) {
+        uint8_t cod = orig[i++];
+        if ((cod == 0) || ((i + cod - 1) > n)) {
+            return -1;
+        }
+        for (int j = 1; j < cod; j++) {
+            if (orig[i] == 0) {
+                return -1;
+            }
+            dest[tam++] = orig[i++];
+        }
+        if ((cod != 0xFF) && (i < n)) {
+            dest[tam++] = 0;
+        }
+    }
+    return tam;
+}
+
+// Monta um registro codificado e terminado, retorna o tamanho
+int telMonta (uint8_t *quadro, uint8_t tipo, uint32_t tempo, const uint8_t *dados, int n) {
+    uint8_t reg[TEL_MAX_REG];
+
+    if (n > TEL_MAX_DADOS) {
+        n = TEL_MAX_DADOS;
+    }
+    reg[0] = tipo;
+    reg[1] = (uint8_t) tempo;
+    reg[2] = (uint8_t) (tempo >> 8);
+    reg[3] = (uint8_t) (tempo >> 16);
+    reg[4] = (uint8_t) (tempo >> 24);
+    memcpy (&reg[5], dados, n);
+    reg[5+n] = crc8(reg, 5+n);
+    int tam = cobsCodifica (quadro, reg, 6+n);
+    quadro[tam++] = 0;
+    return tam;
+}
+
+// Decodifica um quadro (sem o terminador)
+// Retorna o tamanho do registro ou -1 se inválido
+int telDecodifica (uint8_t *reg, const uint8_t *quadro, int n) {
+    if ((n < 2) || (n > (TEL_MAX_QUADRO-1))) {
+        return -1;
+    }
+    int tam = cobsDecodifica (reg, quadro, n);
+    if ((tam < 6) || (crc8(reg, tam-1) != reg[tam-1])) {
+        return -1;
+    }
+    return tam;
+}
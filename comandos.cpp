@@ -0,0 +1,408 @@
+/**
+ * @file comandos.cpp
+ * @author Daniel Quadros
+ * @brief Interpretador de comandos pela serial
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Os caracteres são tratados um a um, à medida que chegam, num buffer
+ * de tamanho fixo. Os comandos estão numa tabela constante; não há
+ * alocação dinâmica de memória.
+ *
+ * Comandos:
+ *   get [liga|desliga|temp|rele|modo]
+ *   set liga|desliga <graus>
+ *   sensores
+ *   stats
+ *   energia
+ *   uso
+ *   hora [<dia> <hh:mm>]
+ *   agenda [<n> <dias> <hh:mm> <liga> <desliga> | <n> apaga]
+ *   salva
+ *   modo histerese|pid|antecipa
+ *   autotune
+ *   ajuda
+ *
+ * As respostas começam com "ok" ou "erro", para facilitar o uso
+ * por scripts.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comandos.h"
+
+#define MAX_PARAM 5
+
+// Um comando: nome, rotina, descrição
+typedef struct {
+    const char *nome;
+    void (*exec) (int nParam, char *param[]);
+    const char *ajuda;
+} COMANDO;
+
+// Resposta formatada (sem alocação, buffer local)
+static void responde (const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void responde (const char *fmt, ...) {
+    char buf[80];
+    va_list va;
+    va_start (va, fmt);
+    vsnprintf (buf, sizeof(buf), fmt, va);
+    va_end (va);
+    appEscreve (buf);
+}
+
+// Converte um inteiro, retorna false se inválido
+static bool pegaInt (const char *txt, int *val) {
+    char *fim;
+    long v = strtol (txt, &fim, 10);
+    if ((*txt == 0) || (*fim != 0)) {
+        return false;
+    }
+    *val = (int) v;
+    return true;
+}
+
+// Converte um horário hh:mm para minutos, retorna false se inválido
+static bool pegaHora (const char *txt, int *minuto) {
+    char *fim;
+    long h = strtol (txt, &fim, 10);
+    if ((fim == txt) || (*fim != ':')) {
+        return false;
+    }
+    const char *pm = fim + 1;
+    long m = strtol (pm, &fim, 10);
+    if ((fim == pm) || (*fim != 0) || (h < 0) || (h > 23) || (m < 0) || (m > 59)) {
+        return false;
+    }
+    *minuto = (int) (h*60 + m);
+    return true;
+}
+
+// Dias da semana
+static const char *nomeDia[] = { "dom", "seg", "ter", "qua", "qui", "sex", "sab" };
+
+// Nome do modo de controle
+static const char *nomeModo (int modo) {
+    switch (modo) {
+        case CTL_PID:      return "pid";
+        case CTL_AUTOTUNE: return "autotune";
+        case CTL_ANTECIPA: return "antecipa";
+    }
+    return "histerese";
+}
+
+// Escreve uma temperatura em 1/16 grau como decimal
+static void respondeTemp (const char *prefixo, int32_t temp) {
+    int32_t milesimos = (temp * 1000) / TEMP_ESCALA;
+    const char *sinal = (milesimos < 0) ? "-" : "";
+    if (milesimos < 0) {
+        milesimos = -milesimos;
+    }
+    responde ("%s%s%ld.%03ld", prefixo, sinal, (long) (milesimos / 1000), (long) (milesimos % 1000));
+}
+
+// get [liga|desliga|temp|rele|modo]
+static void cmdGet (int nParam, char *param[]) {
+    int liga, desliga;
+    appLeSetPoints (&liga, &desliga);
+    if (nParam == 0) {
+        responde ("ok liga %d desliga %d", liga, desliga);
+        respondeTemp ("ok temp ", appTemperatura());
+        responde ("ok rele %d modo %s", appRele() ? 1 : 0, nomeModo(appModo()));
+    } else if (strcmp(param[0], "liga") == 0) {
+        responde ("ok %d", liga);
+    } else if (strcmp(param[0], "desliga") == 0) {
+        responde ("ok %d", desliga);
+    } else if (strcmp(param[0], "temp") == 0) {
+        respondeTemp ("ok ", appTemperatura());
+    } else if (strcmp(param[0], "rele") == 0) {
+        responde ("ok %d", appRele() ? 1 : 0);
+    } else if (strcmp(param[0], "modo") == 0) {
+        responde ("ok %s", nomeModo(appModo()));
+    } else {
+        responde ("erro parametro %s", param[0]);
+    }
+}
+
+// set liga|desliga <graus>
+// Aplica as mesmas restrições da configuração pelo encoder
+static void cmdSet (int nParam, char *param[]) {
+    int liga, desliga, val;
+    if ((nParam != 2) || !pegaInt(param[1], &val)) {
+        responde ("erro uso: set liga|desliga <graus>");
+        return;
+    }
+    appLeSetPoints (&liga, &desliga);
+    if (strcmp(param[0], "liga") == 0) {
+        liga = val;
+    } else if (strcmp(param[0], "desliga") == 0) {
+        desliga = val;
+    } else {
+        responde ("erro parametro %s", param[0]);
+        return;
+    }
+    if ((liga < 0) || (desliga > 99) || (liga >= desliga)) {
+        responde ("erro faixa: 0 <= liga < desliga <= 99");
+        return;
+    }
+    appMudaSetPoints (liga, desliga);
+    responde ("ok liga %d desliga %d", liga, desliga);
+}
+
+// sensores
+static void cmdSensores (int, char *[]) {
+    int32_t temps[CMD_MAX_SENSORES];
+    int n = appSensores (temps, CMD_MAX_SENSORES);
+    char prefixo[16];
+    for (int i = 0; i < n; i++) {
+        snprintf (prefixo, sizeof(prefixo), "ok %d ", i);
+        respondeTemp (prefixo, temps[i]);
+    }
+    responde ("ok %d sensores", n);
+}
+
+// stats
+static void cmdStats (int, char *[]) {
+    CMD_ESTAT est;
+    appEstatisticas (&est);
+    responde ("ok tempo %lu ms", (unsigned long) est.tempo);
+    responde ("ok passos %lu trocas %lu", (unsigned long) est.passos, (unsigned long) est.trocas);
+    responde ("ok passo max %lu us", (unsigned long) est.maxPasso);
+    responde ("ok primeira decisao %lu us", (unsigned long) est.primeiraDecisao);
+    responde ("ok saida %d kp %ld ki %ld kd %ld", est.saida,
+              (long) est.par.kp, (long) est.par.ki, (long) est.par.kd);
+    responde ("ok antecipa liga %lu s desliga %lu s medidas %lu",
+              (unsigned long) (est.antLiga / 1000), (unsigned long) (est.antDesliga / 1000),
+              (unsigned long) est.nMedidas);
+}
+
+// energia
+static void cmdEnergia (int, char *[]) {
+    CMD_ENERGIA e;
+    appEnergia (&e);
+    responde ("ok clock %lu kHz economia %d", (unsigned long) e.clkKHz, e.economia ? 1 : 0);
+    for (int core = 0; core < 2; core++) {
+        responde ("ok core%d ativo %lu.%lu%% esperas %lu em %lu ms", core,
+                  (unsigned long) e.ativo[core] / 10, (unsigned long) e.ativo[core] % 10,
+                  (unsigned long) e.esperas[core], (unsigned long) e.intervalo);
+    }
+}
+
+// Escreve uma fração em 0,1% como decimal
+static void respondeCiclo (const char *prefixo, uint32_t ciclo, const char *sufixo) {
+    responde ("%s%lu.%lu%%%s", prefixo, (unsigned long) ciclo / 10, (unsigned long) ciclo % 10, sufixo);
+}
+
+// uso
+static void cmdUso (int, char *[]) {
+    USO_RESUMO r;
+    char sufixo[24];
+    appUso (&r);
+    responde ("ok ligado %lu s de %lu s", (unsigned long) r.total.segLigado,
+              (unsigned long) r.total.segContado);
+    responde ("ok ciclos %lu curtos %lu", (unsigned long) r.total.ciclos,
+              (unsigned long) r.total.curtos);
+    respondeCiclo ("ok hora ", r.cicloHora, "");
+    snprintf (sufixo, sizeof(sufixo), " em %d h", r.nHoras);
+    respondeCiclo ("ok horas ", r.ciclo24h, sufixo);
+    snprintf (sufixo, sizeof(sufixo), " em %d d", r.nDias);
+    respondeCiclo ("ok dias ", r.cicloDias, sufixo);
+    responde ("ok 24h ciclos %lu curtos %lu ultimo %lu s", (unsigned long) r.ciclos24h,
+              (unsigned long) r.curtos24h, (unsigned long) r.ultimoCiclo / 1000);
+    if (r.alerta) {
+        responde ("ok alerta ciclos curtos");
+    }
+}
+
+// hora [<dia> <hh:mm>]
+static void cmdHora (int nParam, char *param[]) {
+    int dia, minuto;
+    if (nParam == 2) {
+        for (dia = 0; dia < 7; dia++) {
+            if (strcmp(param[0], nomeDia[dia]) == 0) {
+                break;
+            }
+        }
+        if ((dia == 7) || !pegaHora(param[1], &minuto)) {
+            responde ("erro uso: hora dom|seg|ter|qua|qui|sex|sab <hh:mm>");
+            return;
+        }
+        appAcertaHora (dia, minuto);
+    } else if (nParam != 0) {
+        responde ("erro uso: hora [<dia> <hh:mm>]");
+        return;
+    }
+    if (!appLeHora(&dia, &minuto)) {
+        responde ("erro relogio nao acertado");
+        return;
+    }
+    responde ("ok %s %02d:%02d", nomeDia[dia], minuto / 60, minuto % 60);
+}
+
+// agenda [<n> <dias> <hh:mm> <liga> <desliga> | <n> apaga]
+// Os dias são 7 caracteres, a partir do domingo: "x" vale, "-" não
+static void cmdAgenda (int nParam, char *param[]) {
+    AGENDA ag;
+    int n;
+    appLeAgenda (&ag);
+    if (nParam == 0) {
+        for (int i = 0; i < AGENDA_MAX; i++) {
+            const ENTRADA_AGENDA *e = &ag.ent[i];
+            if (e->dias == 0) {
+                responde ("ok %d desativada", i);
+            } else {
+                char dias[8];
+                agendaEscreveDias (e->dias, dias);
+                responde ("ok %d %s %02d:%02d liga %d desliga %d", i, dias,
+                          e->minuto / 60, e->minuto % 60, e->liga, e->desliga);
+            }
+        }
+        return;
+    }
+    if (!pegaInt(param[0], &n) || (n < 0) || (n >= AGENDA_MAX)) {
+        responde ("erro entrada: 0 a %d", AGENDA_MAX-1);
+        return;
+    }
+    ENTRADA_AGENDA e;
+    if ((nParam == 2) && (strcmp(param[1], "apaga") == 0)) {
+        e = ag.ent[n];
+        e.dias = 0;
+    } else {
+        int minuto, liga, desliga;
+        if ((nParam != 5) || !agendaLeDias(param[1], &e.dias) || !pegaHora(param[2], &minuto) ||
+            !pegaInt(param[3], &liga) || !pegaInt(param[4], &desliga)) {
+            responde ("erro uso: agenda <n> <dias> <hh:mm> <liga> <desliga>");
+            return;
+        }
+        if ((liga < 0) || (desliga > 99) || (liga >= desliga)) {
+            responde ("erro faixa: 0 <= liga < desliga <= 99");
+            return;
+        }
+        e.minuto = (uint16_t) minuto;
+        e.liga = (int8_t) liga;
+        e.desliga = (int8_t) desliga;
+    }
+    ag.ent[n] = e;
+    appMudaAgenda (&ag);
+    responde ("ok");
+}
+
+// salva
+static void cmdSalva (int, char *[]) {
+    appSalvaConfig ();
+    responde ("ok");
+}
+
+// modo histerese|pid|antecipa
+static void cmdModo (int nParam, char *param[]) {
+    if (nParam != 1) {
+        responde ("ok %s", nomeModo(appModo()));
+    } else if (strcmp(param[0], "histerese") == 0) {
+        appPedeModo (CTL_HISTERESE);
+        responde ("ok");
+    } else if (strcmp(param[0], "pid") == 0) {
+        appPedeModo (CTL_PID);
+        responde ("ok");
+    } else if (strcmp(param[0], "antecipa") == 0) {
+        appPedeModo (CTL_ANTECIPA);
+        responde ("ok");
+    } else {
+        responde ("erro modo %s", param[0]);
+    }
+}
+
+// autotune
+static void cmdAutoTune (int, char *[]) {
+    appPedeModo (CTL_AUTOTUNE);
+    responde ("ok");
+}
+
+static void cmdAjuda (int, char *[]);
+
+// Tabela dos comandos
+static const COMANDO comandos[] = {
+    { "get",      cmdGet,      "get [liga|desliga|temp|rele|modo]" },
+    { "set",      cmdSet,      "set liga|desliga <graus>" },
+    { "sensores", cmdSensores, "sensores" },
+    { "stats",    cmdStats,    "stats" },
+    { "energia",  cmdEnergia,  "energia" },
+    { "uso",      cmdUso,      "uso" },
+    { "hora",     cmdHora,     "hora [<dia> <hh:mm>]" },
+    { "agenda",   cmdAgenda,   "agenda [<n> <dias> <hh:mm> <liga> <desliga>|<n> apaga]" },
+    { "salva",    cmdSalva,    "salva" },
+    { "modo",     cmdModo,     "modo [histerese|pid|antecipa]" },
+    { "autotune", cmdAutoTune, "autotune" },
+    { "ajuda",    cmdAjuda,    "ajuda" },
+};
+#define N_COMANDOS (int) (sizeof(comandos)/sizeof(comandos[0]))
+
+// ajuda
+static void cmdAjuda (int, char *[]) {
+    for (int i = 0; i < N_COMANDOS; i++) {
+        responde ("ok %s", comandos[i].ajuda);
+    }
+}
+
+// Separa a linha em palavras e executa o comando
+static void executa (char *linha) {
+    char *palavra[1+MAX_PARAM];
+    int n = 0;
+    char *p = linha;
+
+    while ((*p != 0) && (n <= MAX_PARAM)) {
+        while (*p == ' ') {
+            *p++ = 0;
+        }
+        if (*p == 0) {
+            break;
+        }
+        palavra[n++] = p;
+        while ((*p != 0) && (*p != ' ')) {
+            p++;
+        }
+    }
+    if (n == 0) {
+        return;     // linha vazia
+    }
+    for (int i = 0; i < N_COMANDOS; i++) {
+        if (strcmp(palavra[0], comandos[i].nome) == 0) {
+            comandos[i].exec (n-1, &palavra[1]);
+            return;
+        }
+    }
+    responde ("erro comando %s", palavra[0]);
+}
+
+// Inicia o interpretador
+void cmdInit (INTERPRETADOR *interp) {
+    interp->n = 0;
+    interp->longa = false;
+}
+
+// Trata um caracter recebido, executa o comando ao final da linha
+void cmdRecebe (INTERPRETADOR *interp, char c) {
+    if ((c == '\r') || (c == '\n')) {
+        if (interp->longa) {
+            responde ("erro linha longa");
+        } else {
+            interp->linha[interp->n] = 0;
+            executa (interp->linha);
+        }
+        interp->n = 0;
+        interp->longa = false;
+    } else if ((c == '\b') || (c == 0x7F)) {
+        if (interp->n > 0) {
+            interp->n--;
+        }
+    } else if (interp->n < (CMD_TAM_LINHA-1)) {
+        interp->linha[interp->n++] = c;
+    } else {
+        interp->longa = true;
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file comandos.h
+ * @author Daniel Quadros
+ * @brief Interpretador de comandos pela serial
+ *        Não depende do SDK, é usado também na simulação
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef COMANDOS_H
+#define COMANDOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "controle.h"
+#include "uso.h"
+#include "agenda.h"
+
+#define CMD_TAM_LINHA 48    // tamanho máximo de uma linha de comando
+#define CMD_MAX_SENSORES 8
+
+// Estado do interpretador
+typedef struct {
+    char linha[CMD_TAM_LINHA];
+    int n;
+    bool longa;             // linha maior que o buffer, será descartada
+} INTERPRETADOR;
+
+// Estatísticas apresentadas pelo comando "stats"
+typedef struct {
+    uint32_t tempo;         // tempo desde a partida (ms)
+    uint32_t passos;        // passos do controle executados
+    uint32_t trocas;        // mudanças do relê
+    uint32_t maxPasso;      // maior duração de um passo (us)
+    uint32_t primeiraDecisao;   // instante da primeira decisão (us)
+    int saida;              // última saída do PID
+    PID_PARAM par;          // parâmetros do PID
+    uint32_t antLiga;       // antecipação aprendida (ms)
+    uint32_t antDesliga;
+    uint32_t nMedidas;      // medidas da antecipação
+} CMD_ESTAT;
+
+// Uso do processador apresentado pelo comando "energia"
+typedef struct {
+    uint32_t clkKHz;        // clock do sistema
+    bool economia;          // modo de economia de energia
+    uint32_t intervalo;     // intervalo desde a consulta anterior (ms)
+    uint32_t ativo[2];      // fração do intervalo com cada core ativo (0,1%)
+    uint32_t esperas[2];    // vezes que cada core parou
+} CMD_ENERGIA;
+
+// Inicia o interpretador
+void cmdInit (INTERPRETADOR *interp);
+
+// Trata um caracter recebido, executa o comando ao final da linha
+void cmdRecebe (INTERPRETADOR *interp, char c);
+
+// Funções da aplicação usadas pelos comandos
+// (implementadas no firmware e na simulação)
+void appLeSetPoints (int *liga, int *desliga);
+void appMudaSetPoints (int liga, int desliga);
+void appSalvaConfig (void);
+int32_t appTemperatura (void);
+bool appRele (void);
+int appModo (void);
+void appPedeModo (int modo);
+int appSensores (int32_t *temps, int max);
+void appEstatisticas (CMD_ESTAT *est);
+void appEnergia (CMD_ENERGIA *e);
+void appUso (USO_RESUMO *res);
+bool appLeHora (int *dia, int *minuto);     // false se o relógio não foi acertado
+void appAcertaHora (int dia, int minuto);   // dia da semana (0 = domingo)
+void appLeAgenda (AGENDA *ag);
+void appMudaAgenda (const AGENDA *ag);      // grava e passa a usar
+void appEscreve (const char *txt);
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file config.cpp
+ * @author Daniel Quadros
+ * @brief Configuração mantida em RAM e gravada na EEPROM de forma adiada
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * As cópias na EEPROM têm o formato de copias.h; os dados são a
+ * versão e o tamanho da configuração, seguidos da CONFIG da versão que
+ * gravou (o tamanho dos dados varia conforme a versão). O restante do
+ * espaço da cópia não é usado.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "copias.h"
+
+// Identificação das cópias da configuração
+#define MAGICA  0x43464721u
+
+// Início dos dados de uma cópia
+typedef struct {
+    uint16_t versao;
+    uint16_t tamanho;       // tamanho da configuração
+} CAB_CONFIG;
+
+// Dados de uma cópia gravada por esta versão
+typedef struct {
+    CAB_CONFIG cab;
+    CONFIG cfg;
+} DADOS_CONFIG;
+
+// Bytes usados da cópia
+#define CFG_USADO COPIA_TAM(sizeof(DADOS_CONFIG))
+
+static_assert(CFG_USADO <= CFG_TAM_COPIA, "CONFIG grande demais para CFG_TAM_COPIA");
+
+// Valores padrão
+void configPadrao (CONFIG *cfg) {
+    memset (cfg, 0, sizeof(CONFIG));
+    cfg->tempLiga = 20;
+    cfg->tempDesliga = 25;
+}
+
+// Verifica uma cópia, retorna o tamanho da configuração ou -1 se inválida
+static int configValida (const uint8_t *img, uint32_t *seq) {
+    CAB_CONFIG cab;
+
+    memcpy (&cab, img + COPIA_CAB, sizeof(cab));
+    if ((cab.versao == 0) ||
+        (COPIA_TAM(sizeof(CAB_CONFIG) + cab.tamanho) > CFG_TAM_COPIA) ||
+        !copiaValida (img, MAGICA, sizeof(CAB_CONFIG) + cab.tamanho, seq)) {
+        return -1;
+    }
+    return cab.tamanho;
+}
+
+// Carrega a configuração das cópias em base e base+CFG_TAM_COPIA
+int configInit (GERCONFIG *g, uint32_t base, int pagina) {
+    memset (g, 0, sizeof(GERCONFIG));
+    g->base = base;
+    g->pagina = pagina;
+    configPadrao (&g->atual);
+
+    // Lê as duas cópias e escolhe a mais recente válida
+    bool valida[2];
+    uint32_t seqs[2];
+    int tam[2];
+    for (int i = 0; i < 2; i++) {
+        g->imagemOk[i] = appEepromLe (g->imagem[i], base + i*CFG_TAM_COPIA, CFG_TAM_COPIA);
+        tam[i] = g->imagemOk[i] ? configValida (g->imagem[i], &seqs[i]) : -1;
+        valida[i] = tam[i] >= 0;
+    }
+    int melhor = copiaMaisRecente (valida, seqs);
+    if (melhor < 0) {
+        g->seq = 0;
+        g->sujo = true;
+        return CFG_PADRAO;
+    }
+    g->seq = seqs[melhor];
+
+    // Campos que não existiam na versão que gravou ficam com o padrão;
+    // campos de uma versão posterior são ignorados
+    int tamMelhor = tam[melhor];
+    if (tamMelhor > (int) sizeof(CONFIG)) {
+        tamMelhor = sizeof(CONFIG);
+    }
+    memcpy (&g->atual, g->imagem[melhor] + COPIA_CAB + sizeof(CAB_CONFIG), tamMelhor);
+    return CFG_LIDA;
+}
+
+// Altera a configuração; só marca como suja se algum campo mudou
+void configMuda (GERCONFIG *g, const CONFIG *nova, uint32_t agora) {
+    if (memcmp (nova, &g->atual, sizeof(CONFIG)) != 0) {
+        memcpy (&g->atual, nova, sizeof(CONFIG));
+        g->sujo = true;
+        g->tMudanca = agora;
+    }
+}
+
+// Grava a configuração se estiver suja e sem alterações por CFG_QUIETO_MS
+bool configPoll (GERCONFIG *g, uint32_t agora) {
+    if (!g->sujo || ((agora - g->tMudanca) < CFG_QUIETO_MS)) {
+        return false;
+    }
+    if (!configGrava (g)) {
+        // Tenta de novo depois de outro período
+        g->tMudanca = agora;
+        return false;
+    }
+    return true;
+}
+
+// Grava imediatamente se estiver suja
+// A nova configuração vai na cópia mais antiga; só são gravadas as
+// páginas que diferem do que já está nessa cópia
+bool configGrava (GERCONFIG *g) {
+    if (!g->sujo) {
+        return true;
+    }
+
+    uint32_t seq = g->seq + 1;
+    int alvo = seq & 1;
+    uint8_t nova[CFG_TAM_COPIA];
+    DADOS_CONFIG dados;
+    memset (&dados, 0, sizeof(dados));
+    dados.cab.versao = CFG_VERSAO;
+    dados.cab.tamanho = sizeof(CONFIG);
+    dados.cfg = g->atual;
+    copiaMonta (nova, MAGICA, seq, &dados, sizeof(dados));
+
+    uint32_t addr = g->base + alvo*CFG_TAM_COPIA;
+    bool ok = true;
+    int ofs = 0;
+    while (ok && (ofs < (int) CFG_USADO)) {
+        int n = g->pagina - ((addr + ofs) % g->pagina);
+        if (n > ((int) CFG_USADO - ofs)) {
+            n = CFG_USADO - ofs;
+        }
+        if (!g->imagemOk[alvo] || (memcmp (nova + ofs, g->imagem[alvo] + ofs, n) != 0)) {
+            ok = appEepromGrava (nova + ofs, addr + ofs, n);
+            g->nPaginas++;
+        }
+        ofs += n;
+    }
+
+    if (!ok) {
+        // Não sabemos o que ficou na cópia
+        g->imagemOk[alvo] = false;
+        return false;
+    }
+    memcpy (g->imagem[alvo], nova, CFG_USADO);
+    g->imagemOk[alvo] = true;
+    g->seq = seq;
+    g->sujo = false;
+    g->nGravacoes++;
+    return true;
+}
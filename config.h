@@ -0,0 +1,88 @@
+/**
+ * @file config.h
+ * @author Daniel Quadros
+ * @brief Configuração mantida em RAM e gravada na EEPROM de forma adiada
+ *        Não depende do SDK, é usado também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * A configuração em uso fica em RAM. As alterações só marcam a
+ * configuração como suja; a gravação é feita quando não há alterações
+ * por CFG_QUIETO_MS (ou imediatamente, a pedido), de modo que várias
+ * alterações seguidas custam uma única gravação.
+ *
+ * São mantidas duas cópias na EEPROM, gravadas alternadamente; uma
+ * falta de energia no meio de uma gravação não perde a configuração
+ * anterior. Uma cópia do conteúdo de cada cópia é mantida em RAM e
+ * somente as páginas que mudaram são gravadas.
+ *
+ * Cada cópia tem a versão e o tamanho dos dados. Novos campos são
+ * acrescentados no final de CONFIG: ao ler uma cópia de uma versão
+ * anterior os campos que faltam ficam com o valor padrão.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Campos da configuração
+// Novos campos sempre no final (e com o padrão em configPadrao)
+typedef struct {
+    int16_t tempLiga;       // set points (graus)
+    int16_t tempDesliga;
+    // versão 2
+    uint16_t antLiga;       // antecipação aprendida ao ligar (s, 0 = não aprendida)
+    uint16_t antDesliga;    // antecipação aprendida ao desligar (s)
+} CONFIG;
+
+#define CFG_VERSAO      2       // incrementar ao acrescentar campos
+#define CFG_TAM_COPIA   64      // espaço de cada cópia na EEPROM
+#define CFG_QUIETO_MS   5000    // tempo sem alterações para gravar
+
+// Resultado de configInit
+#define CFG_LIDA    0       // configuração lida da EEPROM
+#define CFG_PADRAO  1       // nenhuma cópia válida, usando o padrão
+
+// Gerenciador da configuração
+typedef struct {
+    CONFIG atual;           // configuração em uso
+    bool sujo;              // alterada e ainda não gravada
+    uint32_t tMudanca;      // instante da última alteração (ms)
+    uint32_t seq;           // sequência da última cópia gravada
+    uint32_t base;          // endereço da primeira cópia na EEPROM
+    int pagina;             // tamanho da página da EEPROM
+    uint8_t imagem[2][CFG_TAM_COPIA];   // conteúdo de cada cópia na EEPROM
+    bool imagemOk[2];       // false se o conteúdo não é conhecido
+    uint32_t nGravacoes;    // estatísticas
+    uint32_t nPaginas;
+} GERCONFIG;
+
+// Funções fornecidas pela aplicação para acesso à EEPROM
+bool appEepromLe (uint8_t *buffer, uint32_t addr, int n);
+bool appEepromGrava (const uint8_t *buffer, uint32_t addr, int n);
+
+// Valores padrão
+void configPadrao (CONFIG *cfg);
+
+// Carrega a configuração das cópias em base e base+CFG_TAM_COPIA
+// base deve ser múltiplo de pagina
+// Se não tiver cópia válida, fica com o padrão marcado como sujo
+int configInit (GERCONFIG *g, uint32_t base, int pagina);
+
+// Altera a configuração; só marca como suja se algum campo mudou
+void configMuda (GERCONFIG *g, const CONFIG *nova, uint32_t agora);
+
+// Grava a configuração se estiver suja e sem alterações por CFG_QUIETO_MS
+// Retorna true se gravou
+bool configPoll (GERCONFIG *g, uint32_t agora);
+
+// Grava imediatamente se estiver suja (pedido explícito ou falta de
+// energia). Retorna false se a gravação falhou
+bool configGrava (GERCONFIG *g);
+
+#endif
@@ -0,0 +1,436 @@
+/**
+ * @file controle.cpp
+ * @author Daniel Quadros
+ * @brief Lógica de controle do termostato
+ *        Histerese simples, PID em ponto fixo com acionamento do relê
+ *        proporcional ao tempo, auto-sintonia pelo método do relê e
+ *        histerese antecipada pela tendência da temperatura
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * O RP2040 não tem unidade de ponto flutuante, por isso todas as
+ * contas são feitas com inteiros. O passo é executado uma vez a cada
+ * leitura dos sensores (centenas de ms), bem longe de ser crítico.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "controle.h"
+
+// Valores padrão do PID, adequados para um ambiente com aquecedor
+// Kp: 50% de saída para 1 grau de erro
+// Ti: 20 minutos, Td: 30 segundos
+#define KP_PADRAO       ((500*256)/TEMP_ESCALA)
+#define KI_PADRAO       ((KP_PADRAO*256)/1200)
+#define KD_PADRAO       (KP_PADRAO*30)
+#define FILTRO_D        16      // constante do filtro da derivada (em passos)
+#define JANELA_PADRAO   300000      // 5 minutos
+#define MIN_LIGADO      60000
+#define MIN_DESLIGADO   60000
+
+// Auto-sintonia
+#define AT_HIST     (TEMP_ESCALA/4)     // histerese em torno do set point
+#define AT_CICLOS   3                   // ciclos medidos (o primeiro é descartado)
+#define AT_TEMPO_MAX (8UL*60UL*60UL*1000UL)    // desiste depois de 8 horas
+
+// Antecipação
+// Esquecimento lambda = 1 - 2^-ANT_K por passo (memória de uns 50 s
+// com as leituras a cada 750 ms); os ganhos equivalentes são
+// alfa = 1 - lambda^2 e beta = (1 - lambda)^2
+#define ANT_K           6
+#define ANT_ALFA_NUM    ((2 << ANT_K) - 1)          // alfa = ANT_ALFA_NUM / ANT_DEN
+#define ANT_DEN         (1 << (2*ANT_K))            // beta = 1 / ANT_DEN
+#define ANT_MIN_AMOSTRAS (4 << ANT_K)               // passos até a estimativa valer
+#define ANT_INCL_MIN    ((TEMP_ESCALA*65536)/(4*3600))  // 0,25 grau/hora (Q16)
+#define ANT_FIM         (256/2)                     // 1/32 grau além do extremo (Q8)
+#define ANT_TA_MAX      (30UL*60UL*1000UL)          // antecipação máxima (ms)
+#define ANT_PESO        4                           // peso de uma nova medida: 1/4
+
+// Limita um valor a uma faixa
+static inline int32_t limita(int64_t val, int32_t min, int32_t max) {
+    if (val < min) {
+        return min;
+    }
+    if (val > max) {
+        return max;
+    }
+    return (int32_t) val;
+}
+
+// Set point usado pelo PID e pela auto-sintonia
+static inline int32_t setPoint(CONTROLE *ctl) {
+    return (ctl->tempLiga + ctl->tempDesliga) / 2;
+}
+
+// Inicia o controle no modo indicado, com parâmetros padrão
+void controleInit (CONTROLE *ctl, int modo) {
+    memset (ctl, 0, sizeof(CONTROLE));
+    ctl->par.kp = KP_PADRAO;
+    ctl->par.ki = KI_PADRAO;
+    ctl->par.kd = KD_PADRAO;
+    ctl->par.janela = JANELA_PADRAO;
+    ctl->par.minLigado = MIN_LIGADO;
+    ctl->par.minDesligado = MIN_DESLIGADO;
+    controleModo (ctl, modo);
+}
+
+// Altera o modo de controle
+void controleModo (CONTROLE *ctl, int modo) {
+    if (modo == CTL_AUTOTUNE) {
+        controleAutoTune (ctl);
+        return;
+    }
+    ctl->modo = modo;
+    ctl->ant.nAmostras = 0;
+    ctl->ant.medindo = false;
+    ctl->iAcc = 0;
+    ctl->dFiltro = 0;
+    ctl->saida = 0;
+    ctl->iniciado = false;
+}
+
+// Atualiza os set points (em graus)
+void controleSetPoints (CONTROLE *ctl, int liga, int desliga) {
+    ctl->tempLiga = liga * TEMP_ESCALA;
+    ctl->tempDesliga = desliga * TEMP_ESCALA;
+}
+
+// Desliga o relê sem executar o controle (sem temperatura válida)
+// A troca conta para os tempos mínimos; a estimativa da antecipação
+// recomeça quando voltar a ter temperatura
+void controleDesliga (CONTROLE *ctl, uint32_t agora) {
+    if (ctl->ligado) {
+        ctl->ligado = false;
+        ctl->ultimaTroca = agora;
+    }
+    ctl->tAnt = agora;
+    ctl->ant.nAmostras = 0;
+    ctl->ant.medindo = false;
+}
+
+// Dispara a auto-sintonia do PID
+void controleAutoTune (CONTROLE *ctl) {
+    if (ctl->modo != CTL_AUTOTUNE) {
+        ctl->at.modoAnt = ctl->modo;
+    }
+    ctl->modo = CTL_AUTOTUNE;
+    ctl->at.ciclos = -1;
+    ctl->at.somaAmpl = 0;
+    ctl->at.somaPeriodo = 0;
+    ctl->at.tempoLigado = 0;
+    ctl->at.concluida = false;
+    ctl->iniciado = false;
+}
+
+// Carrega os parâmetros aprendidos pela antecipação
+void controleAntecipacao (CONTROLE *ctl, uint32_t taLiga, uint32_t taDesliga) {
+    ctl->ant.taLiga = (taLiga > ANT_TA_MAX) ? ANT_TA_MAX : taLiga;
+    ctl->ant.taDesliga = (taDesliga > ANT_TA_MAX) ? ANT_TA_MAX : taDesliga;
+    ctl->ant.nMedidas = ((taLiga != 0) || (taDesliga != 0)) ? 1 : 0;
+}
+
+// Desloca os instantes guardados no estado
+void controleAjustaTempo (CONTROLE *ctl, uint32_t delta) {
+    ctl->ultimaTroca += delta;
+    ctl->tAnt += delta;
+    ctl->inicioJanela += delta;
+    ctl->at.inicio += delta;
+    ctl->at.inicioCiclo += delta;
+    ctl->ant.tAnt += delta;
+    ctl->ant.tTroca += delta;
+}
+
+// Verifica se já passou o tempo mínimo desde a última troca do relê
+static bool podeTrocar (CONTROLE *ctl, uint32_t agora) {
+    uint32_t minimo = ctl->ligado ? ctl->par.minLigado : ctl->par.minDesligado;
+    return (agora - ctl->ultimaTroca) >= minimo;
+}
+
+// Calcula os ganhos a partir do resultado da auto-sintonia
+// Usa as regras de Tyreus-Luyben para PI, mais conservadoras que as de
+// Ziegler-Nichols e adequadas para processos lentos como temperatura.
+// O termo derivativo fica desligado: com a resolução do sensor ele só
+// amplifica ruído, e a janela de acionamento já atrasa a resposta.
+static void calculaGanhos (CONTROLE *ctl) {
+    int32_t ampl = ctl->at.somaAmpl / (2*AT_CICLOS);    // meia amplitude
+    uint32_t tu = ctl->at.somaPeriodo / AT_CICLOS;      // período (ms)
+    if ((ampl <= 0) || (tu == 0)) {
+        return;
+    }
+
+    // Ganho crítico Ku = 4d / (pi a), d = metade da saída
+    int64_t ku = ((int64_t) 4 * (SAIDA_MAX/2) * 256 * 1000) / ((int64_t) 3142 * ampl);
+
+    // Kp = Ku/3.2, Ti = 2.2 Tu
+    int64_t kp = (ku * 10) / 32;
+    ctl->par.kp = (int32_t) kp;
+    ctl->par.ki = (int32_t) ((kp * 256 * 10000) / ((int64_t) 22 * tu));
+    ctl->par.kd = 0;
+
+    // Começa o integral com a potência média observada, para evitar
+    // um transitório longo ao entrar no PID
+    ctl->iAcc = (int32_t) (((int64_t) ctl->at.tempoLigado * SAIDA_MAX * 256) / ctl->at.somaPeriodo);
+    ctl->at.concluida = true;
+}
+
+// Passo da auto-sintonia: oscila o relê em torno do set point e mede
+// a amplitude e o período da oscilação resultante
+static bool passoAutoTune (CONTROLE *ctl, int32_t temp, uint32_t agora) {
+    int32_t sp = setPoint(ctl);
+
+    if (!ctl->iniciado) {
+        ctl->at.inicio = agora;
+        ctl->at.tempMax = ctl->at.tempMin = temp;
+        return temp < sp;
+    }
+
+    if (temp > ctl->at.tempMax) {
+        ctl->at.tempMax = temp;
+    }
+    if (temp < ctl->at.tempMin) {
+        ctl->at.tempMin = temp;
+    }
+
+    if ((agora - ctl->at.inicio) > AT_TEMPO_MAX) {
+        // Não conseguiu oscilar, volta ao modo anterior sem mudar os ganhos
+        int modoAnt = ctl->at.modoAnt;
+        controleModo (ctl, modoAnt);
+        ctl->iniciado = true;
+        return false;
+    }
+
+    if (!podeTrocar(ctl, agora)) {
+        return ctl->ligado;
+    }
+
+    if (ctl->ligado && (temp > (sp + AT_HIST))) {
+        if (ctl->at.ciclos > 0) {
+            ctl->at.tempoLigado += agora - ctl->at.inicioCiclo;
+        }
+        return false;
+    }
+    if (!ctl->ligado && (temp < (sp - AT_HIST))) {
+        // Início de um novo ciclo, contabiliza o anterior
+        if (ctl->at.ciclos > 0) {
+            ctl->at.somaAmpl += ctl->at.tempMax - ctl->at.tempMin;
+            ctl->at.somaPeriodo += agora - ctl->at.inicioCiclo;
+        }
+        if (++ctl->at.ciclos > AT_CICLOS) {
+            calculaGanhos (ctl);
+            int32_t iAcc = ctl->iAcc;
+            controleModo (ctl, CTL_PID);
+            ctl->iAcc = iAcc;
+            ctl->iniciado = true;
+            ctl->tempAnt = temp;
+            ctl->tAnt = agora;
+            ctl->inicioJanela = agora;
+            return ctl->ligado;
+        }
+        ctl->at.inicioCiclo = agora;
+        ctl->at.tempMax = ctl->at.tempMin = temp;
+        return true;
+    }
+    return ctl->ligado;
+}
+
+// Passo do PID: calcula a saída e converte em tempo ligado dentro
+// da janela de acionamento
+static bool passoPID (CONTROLE *ctl, int32_t temp, uint32_t agora) {
+    PID_PARAM *par = &ctl->par;
+
+    if (!ctl->iniciado) {
+        ctl->tempAnt = temp;
+        ctl->tAnt = agora;
+        ctl->inicioJanela = agora;
+    }
+
+    int32_t erro = setPoint(ctl) - temp;
+    uint32_t dt = agora - ctl->tAnt;
+
+    // Termo proporcional
+    int64_t saida = ((int64_t) par->kp * erro) / 256;
+
+    if (dt > 0) {
+        // Termo integral, limitado à faixa da saída (anti-windup)
+        int64_t iAcc = ctl->iAcc + ((int64_t) par->ki * erro * dt) / (1000*256);
+        ctl->iAcc = limita (iAcc, 0, SAIDA_MAX*256);
+
+        // Derivada da medida (1/16 grau por segundo, Q8), filtrada para
+        // não amplificar a quantização do sensor
+        int32_t deriv = (int32_t) (((int64_t) (temp - ctl->tempAnt) * 1000 * 256) / dt);
+        ctl->dFiltro += (deriv - ctl->dFiltro) / FILTRO_D;
+    }
+
+    // Termo derivativo, calculado sobre a medida para não reagir
+    // a mudanças no set point
+    saida -= ((int64_t) par->kd * ctl->dFiltro) / (256*256);
+    saida += ctl->iAcc / 256;
+    ctl->saida = limita (saida, 0, SAIDA_MAX);
+    ctl->tempAnt = temp;
+    ctl->tAnt = agora;
+
+    // Avança a janela; o tempo ligado é fixado no início de cada janela
+    // para que o relê mude no máximo duas vezes por janela
+    if (!ctl->iniciado || ((agora - ctl->inicioJanela) >= par->janela)) {
+        if (ctl->iniciado) {
+            ctl->inicioJanela += par->janela;
+            if ((agora - ctl->inicioJanela) >= par->janela) {
+                ctl->inicioJanela = agora;
+            }
+        }
+
+        // Tempo ligado nesta janela, respeitando os tempos mínimos
+        uint32_t tOn = (uint32_t) (((uint64_t) ctl->saida * par->janela) / SAIDA_MAX);
+        if (tOn < par->minLigado) {
+            tOn = 0;
+        } else if ((par->janela - tOn) < par->minDesligado) {
+            tOn = par->janela;
+        }
+        ctl->tempoLigado = tOn;
+    }
+
+    bool ligar = (agora - ctl->inicioJanela) < ctl->tempoLigado;
+    if ((ligar != ctl->ligado) && !podeTrocar(ctl, agora)) {
+        ligar = ctl->ligado;
+    }
+    return ligar;
+}
+
+// Passo da histerese: liga abaixo de tempLiga, desliga acima de tempDesliga
+// Compara em graus inteiros, como na versão original
+static bool passoHisterese (CONTROLE *ctl, int32_t temp) {
+    int32_t graus = TEMP_GRAUS(temp);
+    if (graus < (ctl->tempLiga / TEMP_ESCALA)) {
+        return true;
+    } else if (graus > (ctl->tempDesliga / TEMP_ESCALA)) {
+        return false;
+    }
+    return ctl->ligado;
+}
+
+// Atualiza a estimativa da temperatura e da inclinação
+static void estima (ANTECIPA *ant, int32_t temp, uint32_t agora) {
+    int32_t medida = temp * 256;
+    if (ant->nAmostras == 0) {
+        ant->nivel = medida;
+        ant->incl = 0;
+        ant->tAnt = agora;
+        ant->nAmostras = 1;
+        return;
+    }
+    uint32_t dt = agora - ant->tAnt;
+    if (dt == 0) {
+        return;
+    }
+    ant->tAnt = agora;
+
+    // Previsão pela reta atual e correção pelo resíduo
+    int32_t prev = ant->nivel + (int32_t) (((int64_t) ant->incl * dt) / (1000*256));
+    int64_t residuo = medida - prev;
+    ant->nivel = prev + (int32_t) ((residuo * ANT_ALFA_NUM) / ANT_DEN);
+    ant->incl += (int32_t) ((residuo * 256 * 1000) / ((int64_t) dt * ANT_DEN));
+    ant->nAmostras++;
+}
+
+// Acompanha o efeito da última troca: depois de desligar procura o pico,
+// depois de ligar o vale; quando a temperatura inverte, atualiza o tempo
+// de antecipação correspondente
+static void aprende (CONTROLE *ctl, uint32_t agora) {
+    ANTECIPA *ant = &ctl->ant;
+    if (!ant->medindo) {
+        return;
+    }
+    int32_t sentido = ctl->ligado ? -1 : 1;
+    if ((ant->nivel - ant->extremo) * sentido > 0) {
+        ant->extremo = ant->nivel;
+    } else if ((ant->extremo - ant->nivel) * sentido > ANT_FIM) {
+        ant->medindo = false;
+        int32_t excesso = (ant->extremo - ant->nivelTroca) * sentido;
+        int32_t incl = ant->inclTroca * sentido;
+        if (incl < ANT_INCL_MIN) {
+            return;     // a temperatura estava parada, não dá para medir
+        }
+        uint32_t ta = (uint32_t) limita (((int64_t) excesso * 256 * 1000) / incl, 0, ANT_TA_MAX);
+        uint32_t *alvo = ctl->ligado ? &ant->taLiga : &ant->taDesliga;
+        if (ant->nMedidas == 0) {
+            *alvo = ta;
+        } else {
+            *alvo = (uint32_t) ((int64_t) *alvo + ((int64_t) ta - *alvo) / ANT_PESO);
+        }
+        ant->nMedidas++;
+    } else if ((agora - ant->tTroca) > ANT_TA_MAX) {
+        ant->medindo = false;
+    }
+}
+
+// Inicia a medida do efeito de uma troca do relê
+static void iniciaMedida (ANTECIPA *ant, uint32_t agora) {
+    ant->medindo = ant->nAmostras >= ANT_MIN_AMOSTRAS;
+    ant->nivelTroca = ant->extremo = ant->nivel;
+    ant->inclTroca = ant->incl;
+    ant->tTroca = agora;
+}
+
+// Passo da antecipação: a leitura e a temperatura prevista (a leitura
+// mais a inclinação estimada por taDesliga ou taLiga) são comparadas
+// com os set points como na histerese (em graus, arredondando)
+// A troca nunca é mais tarde que seria sem a antecipação e, com
+// antecipação zero (ou enquanto a estimativa não vale), a decisão é a
+// da histerese
+static bool passoAntecipa (CONTROLE *ctl, int32_t temp, uint32_t agora) {
+    ANTECIPA *ant = &ctl->ant;
+    int32_t prev = temp;
+    if (ant->nAmostras >= ANT_MIN_AMOSTRAS) {
+        uint32_t ta = ctl->ligado ? ant->taDesliga : ant->taLiga;
+        prev = temp + (int32_t) (((int64_t) ant->incl * ta) / (1000*65536));
+    }
+    if (!podeTrocar(ctl, agora)) {
+        return ctl->ligado;
+    }
+    int32_t graus = TEMP_GRAUS(temp);
+    int32_t grausPrev = TEMP_GRAUS(prev);
+    int32_t liga = ctl->tempLiga / TEMP_ESCALA;
+    int32_t desliga = ctl->tempDesliga / TEMP_ESCALA;
+    if (ctl->ligado) {
+        return (graus <= desliga) && (grausPrev <= desliga);
+    }
+    return (graus < liga) || (grausPrev < liga);
+}
+
+// Executa um passo do controle, retorna o novo estado do relê
+bool controlePasso (CONTROLE *ctl, int32_t temp, uint32_t agora) {
+    bool ligar;
+
+    if (!ctl->iniciado) {
+        // Permite acionar o relê logo no primeiro passo
+        ctl->ultimaTroca = agora - (ctl->par.minLigado + ctl->par.minDesligado);
+    }
+    switch (ctl->modo) {
+        case CTL_PID:
+            ligar = passoPID (ctl, temp, agora);
+            break;
+        case CTL_AUTOTUNE:
+            ligar = passoAutoTune (ctl, temp, agora);
+            break;
+        case CTL_ANTECIPA:
+            estima (&ctl->ant, temp, agora);
+            aprende (ctl, agora);
+            ligar = passoAntecipa (ctl, temp, agora);
+            break;
+        default:
+            ligar = passoHisterese (ctl, temp);
+            break;
+    }
+    ctl->iniciado = true;
+    if (ligar != ctl->ligado) {
+        ctl->ligado = ligar;
+        ctl->ultimaTroca = agora;
+        if (ctl->modo == CTL_ANTECIPA) {
+            iniciaMedida (&ctl->ant, agora);
+        }
+    }
+    return ctl->ligado;
+}
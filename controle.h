@@ -0,0 +1,132 @@
+/**
+ * @file controle.h
+ * @author Daniel Quadros
+ * @brief Lógica de controle do termostato (histerese, PID, auto-sintonia
+ *        e antecipação)
+ *        Não depende do SDK, para poder ser usada também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef CONTROLE_H
+#define CONTROLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// As temperaturas são tratadas em ponto fixo, em 1/16 de grau
+// (a resolução nativa do DS18B20)
+#define TEMP_ESCALA 16
+
+// Converte para graus inteiros, arredondando (meio grau se afasta do
+// zero, como o roundf da versão original)
+#define TEMP_GRAUS(t)  (((t) >= 0) ? (((t) + TEMP_ESCALA/2) / TEMP_ESCALA) : \
+                                     -((TEMP_ESCALA/2 - (t)) / TEMP_ESCALA))
+
+// Modos de controle
+#define CTL_HISTERESE 0     // liga/desliga entre tempLiga e tempDesliga
+#define CTL_PID       1     // PID com acionamento proporcional ao tempo
+#define CTL_AUTOTUNE  2     // auto-sintonia do PID em andamento
+#define CTL_ANTECIPA  3     // liga/desliga antecipado pela tendência da temperatura
+
+// Saída do PID, em milésimos da janela de acionamento
+#define SAIDA_MAX     1000
+
+// Parâmetros do PID
+// Os ganhos estão em ponto fixo
+typedef struct {
+    int32_t kp;         // milésimos de saída por 1/16 grau (Q8)
+    int32_t ki;         // milésimos de saída por (1/16 grau * segundo) (Q16)
+    int32_t kd;         // milésimos de saída por (1/16 grau / segundo) (Q8)
+    uint32_t janela;    // período do acionamento proporcional (ms)
+    uint32_t minLigado;     // tempo mínimo com o relê ligado (ms)
+    uint32_t minDesligado;  // tempo mínimo com o relê desligado (ms)
+} PID_PARAM;
+
+// Estado da auto-sintonia (método do relê)
+typedef struct {
+    int modoAnt;        // modo a restaurar ao final
+    int ciclos;         // ciclos completos observados
+    int32_t tempMax;    // pico no ciclo atual
+    int32_t tempMin;    // vale no ciclo atual
+    int32_t somaAmpl;   // soma das amplitudes (pico-a-pico)
+    uint32_t somaPeriodo;   // soma dos períodos (ms)
+    uint32_t tempoLigado;   // soma dos tempos com relê ligado (ms)
+    uint32_t inicioCiclo;   // instante em que ligou o relê no ciclo atual
+    uint32_t inicio;    // instante em que iniciou a sintonia
+    bool concluida;     // true se a última sintonia teve sucesso
+} AUTOTUNE;
+
+// Estado da antecipação
+// A temperatura e a sua inclinação são estimadas a cada passo; depois
+// de cada troca do relê é medido quanto a temperatura ainda continuou
+// no mesmo sentido, o que dá o tempo de antecipação
+typedef struct {
+    int32_t nivel;          // temperatura estimada (1/16 grau, Q8)
+    int32_t incl;           // inclinação estimada (1/16 grau por segundo, Q16)
+    uint32_t nAmostras;     // passos desde o início da estimativa
+    uint32_t tAnt;          // instante do passo anterior (ms)
+    uint32_t taLiga;        // antecipação aprendida ao ligar (ms)
+    uint32_t taDesliga;     // antecipação aprendida ao desligar (ms)
+    uint32_t nMedidas;      // medidas aproveitadas
+    bool medindo;           // acompanhando o efeito da última troca
+    int32_t nivelTroca;     // estimativas no instante da troca
+    int32_t inclTroca;
+    int32_t extremo;        // pico (depois de desligar) ou vale (depois de ligar)
+    uint32_t tTroca;
+} ANTECIPA;
+
+// Estado completo do controle
+typedef struct {
+    int modo;
+    int32_t tempLiga;       // 1/16 grau
+    int32_t tempDesliga;    // 1/16 grau
+    bool ligado;
+    bool iniciado;          // false até o primeiro passo
+    uint32_t ultimaTroca;   // instante da última mudança do relê (ms)
+
+    // PID
+    PID_PARAM par;
+    int32_t iAcc;           // termo integral (milésimos em Q8)
+    int32_t dFiltro;        // derivada filtrada (1/16 grau/s, Q8)
+    int32_t tempAnt;        // temperatura no passo anterior
+    uint32_t tAnt;          // instante do passo anterior (ms)
+    int32_t saida;          // última saída calculada (0 a SAIDA_MAX)
+    uint32_t inicioJanela;  // instante de início da janela atual (ms)
+    uint32_t tempoLigado;   // tempo ligado na janela atual (ms)
+
+    AUTOTUNE at;
+    ANTECIPA ant;
+} CONTROLE;
+
+// Inicia o controle no modo indicado, com parâmetros padrão
+void controleInit (CONTROLE *ctl, int modo);
+
+// Altera o modo de controle
+void controleModo (CONTROLE *ctl, int modo);
+
+// Atualiza os set points (em graus)
+void controleSetPoints (CONTROLE *ctl, int liga, int desliga);
+
+// Executa um passo do controle, retorna o novo estado do relê
+// temp em 1/16 grau, agora em ms
+bool controlePasso (CONTROLE *ctl, int32_t temp, uint32_t agora);
+
+// Desliga o relê sem executar o controle (sem temperatura válida)
+void controleDesliga (CONTROLE *ctl, uint32_t agora);
+
+// Dispara a auto-sintonia do PID
+void controleAutoTune (CONTROLE *ctl);
+
+// Carrega os parâmetros aprendidos pela antecipação (ms, 0 se não
+// foram aprendidos), as medidas seguintes fazem a média com eles
+void controleAntecipacao (CONTROLE *ctl, uint32_t taLiga, uint32_t taDesliga);
+
+// Desloca os instantes guardados no estado (usado quando a base
+// de tempo muda, por exemplo após um reinício)
+void controleAjustaTempo (CONTROLE *ctl, uint32_t delta);
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file copias.cpp
+ * @author Daniel Quadros
+ * @brief Cópias alternadas com sequência e CRC
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Formato de uma cópia:
+ *   identificação (32 bits), sequência (32 bits), dados, CRC-32
+ * Os campos são copiados com memcpy, a imagem não precisa estar
+ * alinhada.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "copias.h"
+
+// CRC-32 (polinômio refletido 0xEDB88320), calculado bit a bit
+// As cópias têm no máximo algumas centenas de bytes, não compensa
+// usar tabela
+uint32_t crc32 (const uint8_t *p, int n) {
+    uint32_t crc = 0xFFFFFFFF;
+    while (n--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// Monta uma cópia com os dados indicados
+void copiaMonta (uint8_t *img, uint32_t magica, uint32_t seq, const void *dados, int n) {
+    memcpy (img, &magica, 4);
+    memcpy (img + 4, &seq, 4);
+    memcpy (img + COPIA_CAB, dados, n);
+    uint32_t crc = crc32 (img, COPIA_CAB + n);
+    memcpy (img + COPIA_CAB + n, &crc, 4);
+}
+
+// Verifica uma cópia com n bytes de dados
+bool copiaValida (const uint8_t *img, uint32_t magica, int n, uint32_t *seq) {
+    uint32_t mag, crc;
+    memcpy (&mag, img, 4);
+    memcpy (&crc, img + COPIA_CAB + n, 4);
+    if ((mag != magica) || (crc != crc32 (img, COPIA_CAB + n))) {
+        return false;
+    }
+    memcpy (seq, img + 4, 4);
+    return true;
+}
+
+// Escolhe a mais recente entre duas cópias
+int copiaMaisRecente (const bool valida[2], const uint32_t seq[2]) {
+    if (valida[0] && valida[1]) {
+        return ((int32_t) (seq[1] - seq[0]) > 0) ? 1 : 0;
+    }
+    return valida[0] ? 0 : valida[1] ? 1 : -1;
+}
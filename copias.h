@@ -0,0 +1,66 @@
+/**
+ * @file copias.h
+ * @author Daniel Quadros
+ * @brief Cópias alternadas com sequência e CRC, usadas para guardar
+ *        dados que não podem ser perdidos numa gravação interrompida
+ *        Não depende do SDK, é usado também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Cada cópia tem a identificação (que distingue o tipo e o formato
+ * dos dados), a sequência, os dados e o CRC-32 de tudo que vem antes
+ * dele. São mantidas duas cópias; a nova vai sempre na mais antiga
+ * (a de índice seq & 1), de modo que uma interrupção no meio de uma
+ * gravação deixa a outra válida. Ao ler vale a cópia válida com a
+ * sequência mais recente (comparada pela diferença, para funcionar na
+ * volta do contador).
+ *
+ * As funções de montagem e verificação trabalham sobre a imagem de
+ * uma cópia em memória (usadas diretamente na retomada, que fica em
+ * RAM); copiasCarrega e copiasGrava (em copias_eeprom.cpp) fazem a
+ * leitura e a gravação na EEPROM, pelas funções fornecidas pela
+ * aplicação.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef COPIAS_H
+#define COPIAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bytes de uma cópia com n bytes de dados
+#define COPIA_CAB       8       // identificação e sequência
+#define COPIA_TAM(n)    (COPIA_CAB + (n) + 4)
+
+// Maior cópia lida ou gravada na EEPROM
+#define COPIA_MAX_EEPROM 64
+
+// Funções fornecidas pela aplicação para acesso à EEPROM
+bool appEepromLe (uint8_t *buffer, uint32_t addr, int n);
+bool appEepromGrava (const uint8_t *buffer, uint32_t addr, int n);
+
+// CRC-32 (polinômio refletido 0xEDB88320)
+uint32_t crc32 (const uint8_t *p, int n);
+
+// Monta em img (COPIA_TAM(n) bytes) uma cópia com os dados indicados
+void copiaMonta (uint8_t *img, uint32_t magica, uint32_t seq, const void *dados, int n);
+
+// Verifica uma cópia com n bytes de dados; se for válida, retorna
+// true e a sua sequência em seq
+bool copiaValida (const uint8_t *img, uint32_t magica, int n, uint32_t *seq);
+
+// Escolhe a mais recente entre duas cópias, -1 se nenhuma é válida
+int copiaMaisRecente (const bool valida[2], const uint32_t seq[2]);
+
+// Carrega os dados da cópia mais recente válida em base e base+tamCopia
+// Retorna false (dados inalterados, seq zerado) se não tiver nenhuma
+bool copiasCarrega (uint32_t magica, void *dados, int n, uint32_t base, int tamCopia, uint32_t *seq);
+
+// Grava os dados na cópia mais antiga, seq é atualizado
+// Se a gravação falhar, a próxima tentativa usa a mesma cópia
+bool copiasGrava (uint32_t magica, const void *dados, int n, uint32_t base, int tamCopia, uint32_t *seq);
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file copias_eeprom.cpp
+ * @author Daniel Quadros
+ * @brief Leitura e gravação na EEPROM de cópias alternadas
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Separado de copias.cpp para que quem só usa as cópias em RAM (a
+ * retomada) não precise das funções de acesso à EEPROM da aplicação.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "copias.h"
+
+// Carrega os dados da cópia mais recente válida
+bool copiasCarrega (uint32_t magica, void *dados, int n, uint32_t base, int tamCopia, uint32_t *seq) {
+    uint8_t img[2][COPIA_MAX_EEPROM];
+    bool valida[2];
+    uint32_t seqs[2];
+
+    *seq = 0;
+    if ((COPIA_TAM(n) > COPIA_MAX_EEPROM) || (COPIA_TAM(n) > tamCopia)) {
+        return false;
+    }
+    for (int i = 0; i < 2; i++) {
+        valida[i] = appEepromLe (img[i], base + i*tamCopia, COPIA_TAM(n)) &&
+                    copiaValida (img[i], magica, n, &seqs[i]);
+    }
+    int melhor = copiaMaisRecente (valida, seqs);
+    if (melhor < 0) {
+        return false;
+    }
+    memcpy (dados, img[melhor] + COPIA_CAB, n);
+    *seq = seqs[melhor];
+    return true;
+}
+
+// Grava os dados na cópia mais antiga, seq é atualizado
+bool copiasGrava (uint32_t magica, const void *dados, int n, uint32_t base, int tamCopia, uint32_t *seq) {
+    uint8_t img[COPIA_MAX_EEPROM];
+
+    if ((COPIA_TAM(n) > COPIA_MAX_EEPROM) || (COPIA_TAM(n) > tamCopia)) {
+        return false;
+    }
+    uint32_t nova = *seq + 1;
+    copiaMonta (img, magica, nova, dados, n);
+    if (!appEepromGrava (img, base + (nova & 1)*tamCopia, COPIA_TAM(n))) {
+        return false;
+    }
+    *seq = nova;
+    return true;
+}
@@ -2,39 +2,24 @@
  * @file display.cpp
  * @author Daniel Quadros
  * @brief Módulo simples para apresentar números e texto num display Nokia 5110
- * @version 2.0
- * @date 2022-09-16
+ * @version 3.0
+ * @date 2026-10-19
+ * 
+ * O driver propriamente dito está em display.h, especializado para as
+ * conexões de cada display; aqui ficam as partes comuns (fonte e
+ * comandos do controlador).
  * 
  * @copyright Copyright (c) 2022, Daniel Quadros
  * 
  */
 
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-
 #include <pico/platform.h>
 #include "pico/stdlib.h"
-#include "hardware/spi.h"
-#include "hardware/dma.h"
-#include "hardware/pio.h"
-
-#include "picotermostato.h"
 
-// Seleção Dado/Comando
-#define LCD_CMD   0
-#define LCD_DAT   1
-
-// Tamanho da tela
-#define LCD_DX    84
-#define LCD_DY    48
-
-// Tamanho caracter normal
-#define LARG_F    5     // largura na fonte
-#define LARG_C    7     // largura na tela
+#include "display.h"
 
 // Gerador de caracteres normal
-static const uint8_t __in_flash() ASCII[][LARG_F]  =
+const uint8_t __in_flash() FONTE_ASCII[][LARG_F]  =
 {
  {0x00, 0x00, 0x00, 0x00, 0x00} // 20  
 ,{0x00, 0x00, 0x5f, 0x00, 0x00} // 21 !
@@ -135,68 +120,26 @@ static const uint8_t __in_flash() ASCII[][LARG_F]  =
 };
 
 // Gerador de caracteres dupla altura / dupla largura (só dígitos)
-static uint8_t DIGITOS[10][LARG_F*4];
+uint8_t FONTE_DIGITOS[10][LARG_F*4];
+static bool fonteDDGerada = false;
 
 // Comandos de iniciação do display
-static const uint8_t __in_flash() lcdInit[] = { 0x21, 0xB0, 0x04, 0x15, 0x20, 0x0C };
+const uint8_t __in_flash() LCD_INIT[6] = { 0x21, 0xB0, 0x04, 0x15, 0x20, 0x0C };
 
 // Compando para colocar o cursor no início da tela
-static const uint8_t __in_flash() lcdHome[] =  { 0x40, 0x80 };
-
-// Cada byte na memória da tela controla 8 pixels alinhados verticalmente
-// Temos duas copias, uma é transferida enquanto a outra é atualizada
-static uint8_t screen[2][LCD_DX*LCD_DY/8];
-static int screenDMA = 0;  // screen programmed in DMA
-
-// Configuração do SPI
-#define BAUD_RATE 4000000   // 4 MHz
-#define DATA_BITS 8
-
-// Número do canal de DMA
-static int dma_chan;
-
-// Indica que o DMA completou a atualização da tela
-static volatile bool screenUpdated = true;
-
-// Esta rotina é executada quando o DMA termina a transferência
-static void dma_irq_handler() {
-    // Limpa o pedido de interrupção
-    dma_hw->ints0 = 1u << dma_chan;
-    // Indica que a tela foi atualizada
-    screenUpdated = true;
-}
-
-// Inicia o DMA
-static void initDMA() {
-    // Obtem um canal
-    dma_chan = dma_claim_unused_channel(true);
-
-    // Configura o canal
-   dma_channel_config c = dma_channel_get_default_config(dma_chan);
-    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
-    channel_config_set_dreq(&c, spi_get_dreq(SPI_ID, true));
-    dma_channel_configure(
-        dma_chan,
-        &c,
-        &spi_get_hw(SPI_ID)->dr,
-        &screen[0][0],   
-        LCD_DX*LCD_DY/8,      
-        false   // Don't start yet.
-    );
-
-    // DMA gera IRQ0 ao final da transferência
-    dma_channel_set_irq0_enabled(dma_chan, true);
-    irq_set_exclusive_handler(DMA_IRQ_0, dma_irq_handler);
-    irq_set_enabled(DMA_IRQ_0, true);
-}
+const uint8_t __in_flash() LCD_HOME[2] =  { 0x40, 0x80 };
 
 // Gera a fonte dupla altura / dupla largura
-static void geraFonteDD() {
+// (uma única vez, mesmo com vários displays)
+void displayGeraFonteDD() {
     uint8_t orig;
     uint16_t novo;
+    if (fonteDDGerada) {
+        return;
+    }
     for (int i = 0; i <= 9; i++) {
         for (int j = 0; j < LARG_F; j++) {
-            orig = ASCII[i+0x10][j];
+            orig = FONTE_ASCII[i+0x10][j];
             novo = 0;
             for (int k = 0; k < 8; k++) {
                 novo = novo >> 2;
@@ -205,130 +148,11 @@ static void geraFonteDD() {
                 }
                 orig = orig >> 1;
             }
-            DIGITOS[i][2*j] = (uint8_t) (novo & 0xFF);
-            DIGITOS[i][2*j+1] = (uint8_t) (novo & 0xFF);
-            DIGITOS[i][2*(LARG_F+j)] = (uint8_t) (novo >> 8);
-            DIGITOS[i][2*(LARG_F+j)+1] = (uint8_t) (novo >> 8);
+            FONTE_DIGITOS[i][2*j] = (uint8_t) (novo & 0xFF);
+            FONTE_DIGITOS[i][2*j+1] = (uint8_t) (novo & 0xFF);
+            FONTE_DIGITOS[i][2*(LARG_F+j)] = (uint8_t) (novo >> 8);
+            FONTE_DIGITOS[i][2*(LARG_F+j)+1] = (uint8_t) (novo >> 8);
         }
     }
+    fonteDDGerada = true;
 }
-
-// Inicia o Display
-void displayInit() {
-    // Configura os pinos de GPIO
-    gpio_init(PIN_SCE);
-    gpio_set_dir(PIN_SCE, true);
-    gpio_put(PIN_SCE, true);
-    gpio_init(PIN_RESET);
-    gpio_set_dir(PIN_RESET, true);
-    gpio_put(PIN_RESET, true);
-    gpio_init(PIN_DC);
-    gpio_set_dir(PIN_DC, true);
-    gpio_put(PIN_DC, true);
-
-    // Configura o SPI
-    uint baud = spi_init (SPI_ID, BAUD_RATE);
-    printf ("SPI @ %u Hz\n", baud);
-    spi_set_format (SPI_ID, DATA_BITS, SPI_CPOL_1, SPI_CPHA_1, 
-                    SPI_MSB_FIRST);
-
-    // Configura os pinos de SPI
-    gpio_set_function(PIN_SCLK, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_SDIN, GPIO_FUNC_SPI);
-
-    // Reseta o controlador do display
-    gpio_put(PIN_RESET, false);
-    sleep_ms(200);
-    gpio_put(PIN_RESET, true);
-
-    // Inicia o controlador do display
-    // (Não usa DMA)
-    gpio_put(PIN_SCE, false);   // deixa selecionado
-    gpio_put(PIN_DC, false);
-    spi_write_blocking(SPI_ID, lcdInit, sizeof(lcdInit));
-    gpio_put(PIN_DC, true);
-
-    // Prepara o DMA
-    initDMA();
-
-    // Inicia a tela
-    displayRefresh();
-
-    // Gera a fonte dupla altura / dupla largura
-    geraFonteDD();
-}
-
-// Atualiza a tela
-void displayRefresh() {
-    // Garante que a atualização anterior foi concluída
-    while (!screenUpdated) {
-        tight_loop_contents();
-    }
-    screenUpdated = false;
-
-    // Muda de buffer
-    screenDMA = 1 - screenDMA;
-
-    // Copia o conteudo atual
-    memcpy (screen[1 - screenDMA], screen[screenDMA], LCD_DX*LCD_DY/8);
-
-    // Posiona cursor no início da memória (sem DMA)
-    gpio_put(PIN_DC, false);
-    spi_write_blocking(SPI_ID, lcdHome, sizeof(lcdHome));
-    gpio_put(PIN_DC, true);
-
-    // Dispara o DMA
-    dma_channel_set_read_addr(dma_chan, screen[screenDMA], true);
-}
-
-// Escreve um caracter na tela
-// l = linha (0 a 5), c = col (0 a 11)
-void displayCar(int l, int c, char car) {
-    int pos = (l*LCD_DX) + c*LARG_C;
-    uint8_t *ps = &screen[1-screenDMA][pos];
-    const uint8_t *pf = ASCII[car-0x20];
-    *ps++ = 0x00;
-    for (int i = 0; i < LARG_F; i++) {
-        *ps++ = *pf++;
-    }
-    *ps++ = 0x00;
-}
-
-// Escreve um string na tela
-// l = linha (0 a 5), c = col (0 a 11)
-void displayStr(int l, int c, const char *str) {
-    while (*str) {
-        displayCar (l, c, *str++);
-        if (c < 11) {
-            c++;
-        } else {
-            c = 0;
-            l++;
-        }
-    }
-}
-
-
-// Escreve um dígito dupla altura / dupla largura
-// l = linha (0 a 4), c = col (0 a 10), dig = digito (0 a 9)
-void displayDigDD(int l, int c, char dig) {
-    int pos = (l*LCD_DX) + c*LARG_C;
-    uint8_t *ps = screen[1-screenDMA]+pos;
-    uint8_t *pd = DIGITOS[dig];
-    for (int i = 0; i < 2; i++) {
-        *ps++ = 0x00;
-        *ps++ = 0x00;
-        for (int i = 0; i < 2*LARG_F; i++) {
-            *ps++ = *pd++;
-        }
-        *ps++ = 0x00;
-        *ps++ = 0x00;
-        ps += LCD_DX - 2*LARG_C;
-    }
-}
-
-// Limpa a tela
-void displayClear() {
-    memset (screen[1-screenDMA], 0, LCD_DX*LCD_DY/8);
-}
-
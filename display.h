@@ -0,0 +1,218 @@
+/**
+ * @file display.h
+ * @author Daniel Quadros
+ * @brief Driver do display Nokia 5110, especializado para as conexões da placa
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Cada instanciação de Display<cfg> tem sua própria tela, canal de DMA
+ * e tratamento de interrupção; o SPI e os pinos são constantes em tempo
+ * de compilação. A fonte é comum a todos os displays (display.cpp).
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#include "placa.h"
+
+// Tamanho da tela
+#define LCD_DX    84
+#define LCD_DY    48
+
+// Tamanho caracter normal
+#define LARG_F    5     // largura na fonte
+#define LARG_C    7     // largura na tela
+#define LCD_COLS  (LCD_DX/LARG_C)   // colunas de texto (12)
+#define LCD_LINS  (LCD_DY/8)        // linhas de texto (6)
+
+// Fonte (display.cpp)
+extern const uint8_t FONTE_ASCII[][LARG_F];
+extern uint8_t FONTE_DIGITOS[10][LARG_F*4];
+void displayGeraFonteDD (void);
+
+// Comandos do controlador
+extern const uint8_t LCD_INIT[6];
+extern const uint8_t LCD_HOME[2];
+
+template <const CFG_DISPLAY &cfg>
+class Display {
+public:
+    // Inicia o Display
+    static void init() {
+        // Configura os pinos de GPIO
+        gpio_init(cfg.sce);
+        gpio_set_dir(cfg.sce, true);
+        gpio_put(cfg.sce, true);
+        gpio_init(cfg.reset);
+        gpio_set_dir(cfg.reset, true);
+        gpio_put(cfg.reset, true);
+        gpio_init(cfg.dc);
+        gpio_set_dir(cfg.dc, true);
+        gpio_put(cfg.dc, true);
+
+        // Configura o SPI
+        uint baud = spi_init (spi(), cfg.baud);
+        printf ("SPI%d @ %u Hz\n", cfg.spi, baud);
+        spi_set_format (spi(), 8, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
+
+        // Configura os pinos de SPI
+        gpio_set_function(cfg.sclk, GPIO_FUNC_SPI);
+        gpio_set_function(cfg.sdin, GPIO_FUNC_SPI);
+
+        // Reseta o controlador do display
+        gpio_put(cfg.reset, false);
+        sleep_ms(200);
+        gpio_put(cfg.reset, true);
+
+        // Inicia o controlador do display
+        // (Não usa DMA)
+        gpio_put(cfg.sce, false);   // deixa selecionado
+        gpio_put(cfg.dc, false);
+        spi_write_blocking(spi(), LCD_INIT, sizeof(LCD_INIT));
+        gpio_put(cfg.dc, true);
+
+        // Prepara o DMA
+        initDMA();
+
+        // Inicia a tela
+        refresh();
+
+        // Gera a fonte dupla altura / dupla largura
+        displayGeraFonteDD();
+    }
+
+    // Atualiza a tela
+    static void refresh() {
+        // Garante que a atualização anterior foi concluída
+        while (!screenUpdated) {
+            tight_loop_contents();
+        }
+        screenUpdated = false;
+
+        // Muda de buffer
+        screenDMA = 1 - screenDMA;
+
+        // Copia o conteudo atual
+        memcpy (screen[1 - screenDMA], screen[screenDMA], LCD_DX*LCD_DY/8);
+
+        // Posiona cursor no início da memória (sem DMA)
+        gpio_put(cfg.dc, false);
+        spi_write_blocking(spi(), LCD_HOME, sizeof(LCD_HOME));
+        gpio_put(cfg.dc, true);
+
+        // Dispara o DMA
+        dma_channel_set_read_addr(dma_chan, screen[screenDMA], true);
+    }
+
+    // Escreve um caracter na tela
+    // l = linha (0 a 5), c = col (0 a 11)
+    static void car(int l, int c, char ch) {
+        int pos = (l*LCD_DX) + c*LARG_C;
+        uint8_t *ps = &screen[1-screenDMA][pos];
+        const uint8_t *pf = FONTE_ASCII[ch-0x20];
+        *ps++ = 0x00;
+        for (int i = 0; i < LARG_F; i++) {
+            *ps++ = *pf++;
+        }
+        *ps++ = 0x00;
+    }
+
+    // Escreve um string na tela
+    // l = linha (0 a 5), c = col (0 a 11)
+    // O que não cabe na linha é descartado
+    static void str(int l, int c, const char *txt) {
+        if ((l < 0) || (l >= LCD_LINS)) {
+            return;
+        }
+        while (*txt && (c < LCD_COLS)) {
+            car (l, c++, *txt++);
+        }
+    }
+
+    // Escreve um dígito dupla altura / dupla largura
+    // l = linha (0 a 4), c = col (0 a 10), dig = digito (0 a 9)
+    static void digDD(int l, int c, int dig) {
+        int pos = (l*LCD_DX) + c*LARG_C;
+        uint8_t *ps = screen[1-screenDMA]+pos;
+        const uint8_t *pd = FONTE_DIGITOS[dig];
+        for (int i = 0; i < 2; i++) {
+            *ps++ = 0x00;
+            *ps++ = 0x00;
+            for (int j = 0; j < 2*LARG_F; j++) {
+                *ps++ = *pd++;
+            }
+            *ps++ = 0x00;
+            *ps++ = 0x00;
+            ps += LCD_DX - 2*LARG_C;
+        }
+    }
+
+    // Limpa a tela
+    static void clear() {
+        memset (screen[1-screenDMA], 0, LCD_DX*LCD_DY/8);
+    }
+
+private:
+    // Cada byte na memória da tela controla 8 pixels alinhados verticalmente
+    // Temos duas copias, uma é transferida enquanto a outra é atualizada
+    static inline uint8_t screen[2][LCD_DX*LCD_DY/8];
+    static inline int screenDMA = 0;  // tela programada no DMA
+
+    // Número do canal de DMA
+    static inline int dma_chan;
+
+    // Indica que o DMA completou a atualização da tela
+    static inline volatile bool screenUpdated = true;
+
+    static spi_inst_t *spi() {
+        return cfg.spi ? spi1 : spi0;
+    }
+
+    // Esta rotina é executada quando o DMA termina a transferência
+    // (a interrupção é compartilhada com os outros displays)
+    static void dma_irq_handler() {
+        if (dma_hw->ints0 & (1u << dma_chan)) {
+            // Limpa o pedido de interrupção
+            dma_hw->ints0 = 1u << dma_chan;
+            // Indica que a tela foi atualizada
+            screenUpdated = true;
+        }
+    }
+
+    // Inicia o DMA
+    static void initDMA() {
+        // Obtem um canal
+        dma_chan = dma_claim_unused_channel(true);
+
+        // Configura o canal
+        dma_channel_config c = dma_channel_get_default_config(dma_chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+        channel_config_set_dreq(&c, spi_get_dreq(spi(), true));
+        dma_channel_configure(
+            dma_chan,
+            &c,
+            &spi_get_hw(spi())->dr,
+            &screen[0][0],
+            LCD_DX*LCD_DY/8,
+            false   // Don't start yet.
+        );
+
+        // DMA gera IRQ0 ao final da transferência
+        dma_channel_set_irq0_enabled(dma_chan, true);
+        irq_add_shared_handler(DMA_IRQ_0, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+    }
+};
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * @file eeprom.h
+ * @author Daniel Quadros
+ * @brief Driver simples para EEProm 24Cxx, especializado para as conexões da placa
+ * @version 2.0
+ * @date 2026-10-19
+ *
+ * Cada instanciação de Eeprom<cfg> acessa uma memória; memórias no
+ * mesmo I2C compartilham o mutex do barramento (eeprom.cpp), pois
+ * são acessadas pelos dois cores.
+ *
+ * O tamanho e a página de gravação vêm da tabela EEPROM_TIPOS (placa.h),
+ * conforme o tipo configurado ou detectado. As gravações são feitas em
+ * páginas inteiras sempre que possível (de 32 bytes no 24C32 a 256
+ * bytes no 24CM02), cada página custa uma espera de até 5 ms.
+ *
+ * A detecção do tamanho usa a posição EE_SONDA (o último byte do
+ * 24C32), que fica reservada e não deve ser usada pela aplicação.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/mutex.h"
+#include "hardware/i2c.h"
+
+#include "placa.h"
+
+// Inicia um I2C (uma única vez) e retorna o mutex do barramento
+mutex_t *eepromBarramento (uint8_t i2c, uint pinSDA, uint pinSCL, uint32_t baud);
+
+// Posição reservada para a detecção do tamanho
+#define EE_SONDA    (EEPROM_TIPOS[EE_24C32].tamanho - 1)
+
+template <const CFG_EEPROM &cfg>
+class Eeprom {
+public:
+    // Inicia o I2C para acesso a EEPROM
+    static void init() {
+        mtx = eepromBarramento (cfg.i2c, cfg.sda, cfg.scl, cfg.baud);
+        tipo = EEPROM_TIPOS[(cfg.tipo == EE_DETECTA) ? detecta() : cfg.tipo];
+        printf ("EEPROM %lu bytes, pagina de %u bytes\n",
+                (unsigned long) tipo.tamanho, tipo.pagina);
+    }
+
+    // Características da memória
+    static uint32_t tamanho() {
+        return tipo.tamanho;
+    }
+    static int pagina() {
+        return tipo.pagina;
+    }
+
+    // Le da EEPROM
+    static bool read(uint8_t *buffer, uint32_t addr, int n) {
+        bool ok = (addr + n) <= tipo.tamanho;
+
+        // Lê aos pedaços, sem atravessar os blocos de 64K
+        mutex_enter_blocking(mtx);
+        while (ok && (n > 0)) {
+            int nLer = 0x10000 - (addr & 0xFFFF);
+            if (nLer > n) {
+                nLer = n;
+            }
+            ok = enviaEndereco(addr, true) &&
+                 (i2c_read_blocking(i2c(), dispositivo(addr), buffer, nLer, false) == nLer);
+            n -= nLer;
+            buffer += nLer;
+            addr += nLer;
+        }
+        mutex_exit(mtx);
+
+        return ok;
+    }
+
+    // Grava na EEProm
+    static bool write(const uint8_t *buffer, uint32_t addr, int n) {
+        bool ok = (addr + n) <= tipo.tamanho;
+
+        // Grava aos pedaços, respeitando as paginas
+        // (as páginas nunca atravessam os blocos de 64K)
+        mutex_enter_blocking(mtx);
+        while (ok && (n > 0)) {
+            uint32_t nextPage = (addr & ~(uint32_t) (tipo.pagina-1)) + tipo.pagina;
+            int nWrt = nextPage - addr;
+            if (nWrt > n) {
+                nWrt = n;
+            }
+            bufAux[0] = (addr >> 8) & 0xFF;
+            bufAux[1] = addr & 0xFF;
+            memcpy (bufAux+2, buffer, nWrt);
+            int ret = i2c_write_blocking (i2c(), dispositivo(addr), bufAux, 2+nWrt, false);
+            if (ret == (2+nWrt)) {
+                esperaGravacao(addr);
+                n -= nWrt;
+                buffer += nWrt;
+                addr += nWrt;
+            } else {
+                ok = false;
+            }
+        }
+        mutex_exit(mtx);
+        return ok;
+    }
+
+private:
+    static inline mutex_t *mtx;
+    static inline EEPROM_TIPO tipo = EEPROM_TIPOS[EE_24C32];
+
+    // Endereço e dados de uma gravação precisam ir na mesma transação
+    // Fica fora da pilha (a gravação é chamada também pelo core 1, que
+    // tem pilha pequena); o acesso é protegido pelo mutex
+    static inline uint8_t bufAux[2+EE_MAX_PAGINA];
+
+    static i2c_inst_t *i2c() {
+        return cfg.i2c ? i2c1 : i2c0;
+    }
+
+    // Endereço I2C para acessar uma posição
+    // (nos 24CMxx inclui a seleção do bloco de 64K)
+    static uint8_t dispositivo(uint32_t addr) {
+        return cfg.endereco | ((addr >> 16) & ((1u << tipo.bitsBloco) - 1));
+    }
+
+    // Envia a posição para uma leitura ou gravação
+    static bool enviaEndereco(uint32_t addr, bool continua) {
+        uint8_t bufAddr[2];
+        bufAddr[0] = (addr >> 8) & 0xFF;
+        bufAddr[1] = addr & 0xFF;
+        return i2c_write_blocking (i2c(), dispositivo(addr), bufAddr, 2, continua) == 2;
+    }
+
+    // Espera concluir gravação
+    // 24Cxx responde ao endereço somente quando concluir
+    static void esperaGravacao(uint32_t addr) {
+        uint8_t aux;
+        while (i2c_read_blocking(i2c(), dispositivo(addr), &aux, 1, false) != 1) {
+            sleep_ms(1);
+        }
+    }
+
+    // Descobre o tamanho da memória (24C32 a 24C512)
+    // As memórias menores ignoram os bits mais significativos do
+    // endereço, uma posição além do fim corresponde a uma do início.
+    // Os candidatos são testados do menor para o maior, pela posição
+    // EE_SONDA e pela sua cópia além do fim do candidato:
+    // - se as duas têm valores diferentes, não é cópia, a memória é maior
+    //   (não precisa gravar nada)
+    // - se são iguais, muda EE_SONDA e vê se a outra mudou junto
+    // Somente o byte reservado EE_SONDA é gravado (e restaurado): numa
+    // memória menor que 24C512 são duas gravações a cada partida, bem
+    // dentro da vida útil da posição.
+    static int detecta() {
+        uint8_t orig;
+
+        tipo = EEPROM_TIPOS[EE_24C512];
+        if (!read(&orig, EE_SONDA, 1)) {
+            printf ("EEPROM nao responde, supondo 24C32\n");
+            return EE_24C32;
+        }
+        for (int cand = EE_24C32; cand < EE_24C512; cand++) {
+            uint32_t copia = EE_SONDA + EEPROM_TIPOS[cand].tamanho;
+            uint8_t antes, depois;
+            if (!read(&antes, copia, 1) || (antes != orig)) {
+                continue;
+            }
+            uint8_t marca = ~orig;
+            write(&marca, EE_SONDA, 1);
+            bool ok = read(&depois, copia, 1);
+            write(&orig, EE_SONDA, 1);
+            if (ok && (depois == marca)) {
+                return cand;
+            }
+        }
+        return EE_24C512;
+    }
+};
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ * @file encoder.h
+ * @author Daniel Quadros
+ * @brief Tratamento do rotary encoder (com botão), especializado para as conexões da placa
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Cada instanciação de Encoder<cfg> tem sua máquina de estado, sua
+ * fila de teclas e seu tratamento de interrupção (compartilhada entre
+ * os encoders da mesma PIO). O programa da PIO e a decodificação dos
+ * passos são comuns (encoder.cpp).
+ *
+ * O botão é tratado por interrupção do GPIO: cada mudança (re)inicia
+ * um alarme e o novo estado é aceito quando o alarme dispara, sem
+ * mudanças por DEBOUNCE_MS. Nada roda enquanto o botão não é mexido.
+ * Ao colocar uma tecla na fila é gerado um evento (__sev), para
+ * acordar o laço principal se estiver parado esperando.
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+#include "placa.h"
+#include "menu.h"
+
+// Partes comuns (encoder.cpp)
+uint encoderPrograma (PIO pio, pio_sm_config *c);
+int encoderPasso (uint32_t recebido);
+
+template <const CFG_ENCODER &cfg>
+class Encoder {
+public:
+    static const int DEBOUNCE_MS = 100;
+    static const int T_FILA = 32;
+    static const uint32_t AMOSTRAGEM_HZ = 500000;  // clock da máquina de estado
+
+    // iniciação do módulo
+    static void init() {
+        PIO p = pio();
+
+        // Inicia a fila
+        poe = tira = 0;
+
+        // Inicia o botão
+        gpio_init(cfg.sw);
+        gpio_set_dir(cfg.sw, GPIO_IN);
+        gpio_pull_up(cfg.sw);
+        sw_apertado = false;
+        alarme = 0;
+        gpio_set_irq_enabled(cfg.sw, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+        gpio_add_raw_irq_handler(cfg.sw, trataBotao);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+
+        // Aloca uma maquina de estado
+        sm = pio_claim_unused_sm(p, true);
+
+        // Carrega o programa (se ainda não carregado nesta PIO)
+        pio_sm_config c;
+        uint offset = encoderPrograma(p, &c);
+
+        // Inicia os pinos conectados ao encoder
+        pio_gpio_init(p, cfg.a);
+        pio_gpio_init(p, cfg.b);
+        gpio_pull_up(cfg.a);
+        gpio_pull_up(cfg.b);
+        pio_sm_set_consecutive_pindirs(p, sm, cfg.a, 1, false);
+        pio_sm_set_consecutive_pindirs(p, sm, cfg.b, 1, false);
+
+        // Configura a maquina de estado
+        sm_config_set_jmp_pin(&c, cfg.a);
+        sm_config_set_in_pins(&c, cfg.b);
+        sm_config_set_in_shift(&c, false, false, 1);
+        sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+        // O divisor depende do clock do sistema (reduzido no modo de economia)
+        sm_config_set_clkdiv_int_frac(&c, clock_get_hz(clk_sys) / AMOSTRAGEM_HZ, 0);
+        pio_sm_init(p, sm, offset, &c);
+
+        // Configura a interrupcao
+        hw_set_bits(&p->inte1, PIO_IRQ1_INTE_SM0_RXNEMPTY_BITS << sm);
+        uint irq = cfg.pio ? PIO1_IRQ_1 : PIO0_IRQ_1;
+        irq_add_shared_handler(irq, pio_interrupt_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(irq, true);
+
+        // Inicia o registrador X, executando a instrução "SET X,state"
+        bool state_a = gpio_get(cfg.a);
+        bool state_b = gpio_get(cfg.b);
+        pio_sm_exec(p, sm, pio_encode_set(pio_x, (uint)state_a << 1 | (uint)state_b));
+
+        // Dispara a execucao da maquina de estado
+        pio_sm_set_enabled(p, sm, true);
+    }
+
+    // informa se tem tecla na fila
+    static bool temTecla() {
+        return tira != poe;
+    }
+
+    // pega próxima tecla da fila, retorna -1 se fila vazia
+    static int tecLe() {
+        if (tira == poe) {
+            return -1;
+        }
+        int tecla = fila[tira];
+        tira = (tira + 1) % T_FILA;
+        return tecla;
+    }
+
+private:
+    static inline uint sm;
+
+    static inline volatile bool sw_apertado;
+    static inline volatile alarm_id_t alarme;
+
+    static inline int fila[T_FILA];
+    static inline volatile int poe, tira;
+
+    static PIO pio() {
+        return cfg.pio ? pio1 : pio0;
+    }
+
+    // coloca tecla na fila
+    static void poeTecla(int tecla) {
+        int prox = (poe + 1) % T_FILA;
+        if (prox != tira) {
+            fila[poe] = tecla;
+            poe = prox;
+            __sev();
+        } else {
+            // fila cheia, ignora
+        }
+    }
+
+    // Interrupção do GPIO do botão
+    static void trataBotao() {
+        if (gpio_get_irq_event_mask(cfg.sw) & (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)) {
+            gpio_acknowledge_irq(cfg.sw, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE);
+            // Mudou, (re)inicia a contagem de debounce
+            if (alarme > 0) {
+                cancel_alarm(alarme);
+            }
+            alarme = add_alarm_in_ms(DEBOUNCE_MS, confirmaBotao, NULL, true);
+        }
+    }
+
+    // Fim do debounce, o botão ficou estável
+    static int64_t confirmaBotao(alarm_id_t id, void *user_data) {
+        alarme = 0;
+        bool atual = ! gpio_get (cfg.sw);
+        if (atual != sw_apertado) {
+            // Validou a mudança de estado
+            sw_apertado = atual;
+            if (atual) {
+                // Coloca na fila quando aperta
+                poeTecla (TECLA_ENTER);
+            }
+        }
+        return 0;   // não repete
+    }
+
+    // Trata a interrupção da PIO
+    // (compartilhada, trata somente a fila da nossa máquina de estado)
+    static void pio_interrupt_handler() {
+        PIO p = pio();
+        while(p->ints1 & (PIO_IRQ1_INTS_SM0_RXNEMPTY_BITS << sm)) {
+            int tecla = encoderPasso(pio_sm_get(p, sm));
+            if (tecla >= 0) {
+                poeTecla(tecla);
+            }
+        }
+    }
+};
+
+#endif
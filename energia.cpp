@@ -0,0 +1,103 @@
+/**
+ * @file energia.cpp
+ * @author Daniel Quadros
+ * @brief Economia de energia: clock reduzido e espera com os cores parados
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Com ECONOMIA definido o clock do sistema e dos periféricos passa a
+ * vir do PLL da USB (48 MHz) e o PLL do sistema é desligado. Isto
+ * precisa ser feito antes de iniciar os periféricos, que calculam os
+ * divisores a partir do clock.
+ *
+ * As esperas são feitas com WFE: o core fica parado até uma interrupção,
+ * um evento (__sev) ou o alarme do fim da espera. O tempo parado de
+ * cada core é acumulado para o comando "energia". O modo dormant não é
+ * usado, pois pára também o timer que marca as leituras e a telemetria.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
+#include "hardware/clocks.h"
+
+#include "picotermostato.h"
+#include "comandos.h"
+
+// Tempo parado e número de esperas de cada core
+// O M0+ acessa 64 bits em duas operações; como cada core atualiza o
+// seu e o core 0 lê os dois, o acesso é feito com critEnergia
+static critical_section critEnergia;
+static uint64_t usParado[2];
+static uint32_t nEsperas[2];
+
+// Valores na consulta anterior, para calcular a fração no intervalo
+static uint64_t usAnt;
+static uint64_t usParadoAnt[2];
+static uint32_t nEsperasAnt[2];
+
+// Ajusta os clocks, chamar antes de iniciar os periféricos
+void energiaInit() {
+#ifdef ECONOMIA
+    set_sys_clock_48mhz();
+#endif
+    critical_section_init(&critEnergia);
+    usAnt = time_us_64();
+}
+
+// Espera até o limite ou até um evento, com o core parado
+// Retorna true se chegou ao limite
+bool energiaEspera(absolute_time_t limite) {
+    uint core = get_core_num();
+    uint64_t t0 = time_us_64();
+    bool fim = best_effort_wfe_or_timeout(limite);
+    uint64_t parado = time_us_64() - t0;
+    critical_section_enter_blocking(&critEnergia);
+    usParado[core] += parado;
+    nEsperas[core]++;
+    critical_section_exit(&critEnergia);
+    return fim;
+}
+
+// Dorme pelo tempo indicado
+// (as interrupções continuam sendo tratadas)
+void energiaDorme(uint32_t ms) {
+    absolute_time_t limite = make_timeout_time_ms(ms);
+    while (!energiaEspera(limite)) {
+    }
+}
+
+// Estatísticas desde a consulta anterior
+void appEnergia(CMD_ENERGIA *e) {
+    uint64_t agora = time_us_64();
+    uint64_t intervalo = agora - usAnt;
+
+    e->clkKHz = clock_get_hz(clk_sys) / 1000;
+#ifdef ECONOMIA
+    e->economia = true;
+#else
+    e->economia = false;
+#endif
+    e->intervalo = (uint32_t) (intervalo / 1000);
+    uint64_t usParadoAtual[2];
+    uint32_t nEsperasAtual[2];
+    critical_section_enter_blocking(&critEnergia);
+    for (int core = 0; core < 2; core++) {
+        usParadoAtual[core] = usParado[core];
+        nEsperasAtual[core] = nEsperas[core];
+    }
+    critical_section_exit(&critEnergia);
+    for (int core = 0; core < 2; core++) {
+        uint64_t parado = usParadoAtual[core] - usParadoAnt[core];
+        e->ativo[core] = (intervalo == 0) ? 0 :
+                         (uint32_t) (1000 - (parado * 1000) / intervalo);
+        e->esperas[core] = nEsperasAtual[core] - nEsperasAnt[core];
+        usParadoAnt[core] = usParadoAtual[core];
+        nEsperasAnt[core] = nEsperasAtual[core];
+    }
+    usAnt = agora;
+}
@@ -0,0 +1,356 @@
+/**
+ * @file frota.cpp
+ * @author Daniel Quadros
+ * @brief Simulação de uma frota de termostatos em paralelo
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Uso: frota [-n termostatos] [-h horas] [-t threads] [-s semente]
+ *            [-m histerese|pid|autotune|antecipa|misto] [-v]
+ *
+ * Cada termostato é uma instância independente do estado do firmware
+ * (termostato.cpp) controlando um ambiente diferente: isolamento,
+ * potência do aquecedor, tempo morto, ruído do sensor, temperatura
+ * externa (com variação diária) e set points são sorteados a partir
+ * da semente e do número do termostato, de forma que o resultado não
+ * depende da distribuição entre as threads.
+ *
+ * Os termostatos são distribuídos entre as threads (por padrão uma por
+ * core); cada thread tem sua fila e, quando ela esvazia, rouba
+ * trabalho do início da fila das outras.
+ *
+ * No final são apresentadas estatísticas de conforto e de acionamento
+ * do relê por modo de controle, descartando as primeiras horas.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "termostato.h"
+#include "planta.h"
+
+#define DT_PLANTA       0.25    // passo da simulação do modelo (s)
+#define PASSOS_LEITURA  3       // uma leitura a cada 3 passos (750 ms)
+#define PASSOS_EXTERNA  240     // atualiza a temperatura externa a cada minuto
+#define AQUECIMENTO     2.0     // horas descartadas nas estatísticas
+#define TROCAS_CURTAS   6.0     // trocas por hora consideradas excessivas
+#define N_PADRAO        500
+#define HORAS_PADRAO    24.0
+
+#define MODO_MISTO      -1
+
+// Um ambiente com seu termostato
+typedef struct {
+    TERMOSTATO termo;
+    PLANTA planta;
+    int modo;
+    double externaMedia;    // temperatura externa média (graus)
+    double externaAmpl;     // variação diária (graus, pico)
+
+    // Resultados (após o aquecimento)
+    double conforto;        // fração do tempo na faixa
+    double grauHoraFrio;    // abaixo de "Liga" (grau*h)
+    double grauHoraCalor;   // acima de "Desliga" (grau*h)
+    double trocasHora;
+    double ciclo;           // fração do tempo com o relê ligado
+} SALA;
+
+// Fila de trabalho de uma thread
+typedef struct {
+    std::mutex mtx;
+    std::deque<int> fila;
+    long executados;
+    long roubados;
+} TRABALHADOR;
+
+static std::vector<SALA> salas;
+static std::vector<TRABALHADOR *> trab;
+static double horas = HORAS_PADRAO;
+
+static const char *nomeModo[] = { "histerese", "pid", "autotune", "antecipa" };
+
+// Gerador pseudo-aleatório simples, para resultados repetíveis
+static uint32_t aleatorio (uint32_t *sem) {
+    *sem = *sem * 1103515245 + 12345;
+    return (*sem >> 8) & 0xFFFFFF;
+}
+
+// Valor aleatório entre min e max
+static double faixa (uint32_t *sem, double min, double max) {
+    return min + (max - min) * (aleatorio(sem) / (double) 0x1000000);
+}
+
+// Sorteia o ambiente e inicia o termostato
+static void montaSala (SALA *sala, uint32_t semente, int modo) {
+    uint32_t sem = semente;
+    for (int i = 0; i < 4; i++) {
+        aleatorio (&sem);   // espalha sementes consecutivas
+    }
+
+    PLANTA_PARAM par;
+    plantaParamPadrao (&par);
+    par.perda *= faixa (&sem, 0.5, 2.0);
+    par.potencia *= faixa (&sem, 0.6, 1.6);
+    par.acoplamento *= faixa (&sem, 0.5, 2.0);
+    par.atraso = faixa (&sem, 10.0, 120.0);
+    par.ruido = faixa (&sem, 0.02, 0.1);
+    sala->externaMedia = faixa (&sem, 0.0, 15.0);
+    sala->externaAmpl = faixa (&sem, 2.0, 8.0);
+    par.tempExterna = sala->externaMedia;
+    plantaInit (&sala->planta, &par, sala->externaMedia + faixa (&sem, 0.0, 10.0), DT_PLANTA);
+    sala->planta.semente = aleatorio (&sem);
+
+    if (modo == MODO_MISTO) {
+        modo = aleatorio(&sem) % 4;
+    }
+    sala->modo = modo;
+    int liga = 18 + aleatorio(&sem) % 4;
+    int desliga = liga + 1 + aleatorio(&sem) % 3;
+    termostatoInit (&sala->termo, modo, liga, desliga);
+}
+
+// Simula um ambiente pelo tempo pedido
+static void simulaSala (SALA *sala) {
+    TERMOSTATO *termo = &sala->termo;
+    PLANTA *planta = &sala->planta;
+    long nPassos = (long) (horas * 3600.0 / DT_PLANTA);
+    long inicio = (long) (AQUECIMENTO * 3600.0 / DT_PLANTA);
+    if (inicio >= nPassos) {
+        inicio = 0;
+    }
+    long naFaixa = 0, ligado = 0;
+    double frio = 0.0, calor = 0.0;
+    uint32_t trocasInicio = 0;
+
+    for (long i = 0; i < nPassos; i++) {
+        double t = i * DT_PLANTA;
+        if ((i % PASSOS_EXTERNA) == 0) {
+            // Mínima às 4 h, máxima às 16 h
+            planta->par.tempExterna = sala->externaMedia -
+                sala->externaAmpl * cos (2.0 * M_PI * (t / 3600.0 - 4.0) / 24.0);
+        }
+        if ((i % PASSOS_LEITURA) == 0) {
+            termostatoPasso (termo, plantaSensor (planta), (uint32_t) (t * 1000.0));
+        }
+        plantaPasso (planta, termo->ligado, DT_PLANTA);
+
+        if (i == inicio) {
+            trocasInicio = termo->nTrocas;
+        }
+        if (i >= inicio) {
+            double temp = planta->tempAmbiente;
+            double baixo = termo->tempLiga - 0.5;
+            double alto = termo->tempDesliga + 0.5;
+            if (temp < baixo) {
+                frio += (baixo - temp) * DT_PLANTA;
+            } else if (temp > alto) {
+                calor += (temp - alto) * DT_PLANTA;
+            } else {
+                naFaixa++;
+            }
+            if (termo->ligado) {
+                ligado++;
+            }
+        }
+    }
+
+    double n = (double) (nPassos - inicio);
+    double h = n * DT_PLANTA / 3600.0;
+    sala->conforto = naFaixa / n;
+    sala->grauHoraFrio = frio / 3600.0;
+    sala->grauHoraCalor = calor / 3600.0;
+    sala->trocasHora = (termo->nTrocas - trocasInicio) / h;
+    sala->ciclo = ligado / n;
+}
+
+// Pega o próximo ambiente: primeiro da própria fila (do fim), depois
+// rouba do início da fila das outras threads
+static int proximo (int id) {
+    TRABALHADOR *eu = trab[id];
+    {
+        std::lock_guard<std::mutex> trava (eu->mtx);
+        if (!eu->fila.empty()) {
+            int sala = eu->fila.back();
+            eu->fila.pop_back();
+            return sala;
+        }
+    }
+    int n = (int) trab.size();
+    for (int i = 1; i < n; i++) {
+        TRABALHADOR *vitima = trab[(id + i) % n];
+        std::lock_guard<std::mutex> trava (vitima->mtx);
+        if (!vitima->fila.empty()) {
+            int sala = vitima->fila.front();
+            vitima->fila.pop_front();
+            eu->roubados++;
+            return sala;
+        }
+    }
+    return -1;  // nenhum trabalho é criado depois do início, acabou
+}
+
+// Laço de uma thread
+static void trabalha (int id) {
+    int sala;
+    while ((sala = proximo(id)) >= 0) {
+        simulaSala (&salas[sala]);
+        trab[id]->executados++;
+    }
+}
+
+static int comparaDouble (const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+// Apresenta média e percentis de um campo das salas de um modo
+static void mostraCampo (const char *nome, int modo, size_t desloc, double escala, const char *fmt) {
+    std::vector<double> val;
+    double soma = 0.0;
+    for (size_t i = 0; i < salas.size(); i++) {
+        if (salas[i].modo == modo) {
+            double v = *(const double *) ((const char *) &salas[i] + desloc) * escala;
+            val.push_back (v);
+            soma += v;
+        }
+    }
+    if (val.empty()) {
+        return;
+    }
+    qsort (&val[0], val.size(), sizeof(double), comparaDouble);
+    size_t n = val.size();
+    char linha[160];
+    snprintf (linha, sizeof(linha), "  %%-22s media %s  p5 %s  p50 %s  p95 %s  max %s\n",
+              fmt, fmt, fmt, fmt, fmt);
+    printf (linha, nome, soma / n, val[n*5/100], val[n/2], val[n*95/100], val[n-1]);
+}
+
+int main(int argc, char *argv[]) {
+    int n = N_PADRAO;
+    int nThreads = (int) std::thread::hardware_concurrency();
+    uint32_t semente = 1;
+    int modo = MODO_MISTO;
+    bool verboso = false;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc)) {
+            n = atoi (argv[++i]);
+        } else if ((strcmp (argv[i], "-h") == 0) && (i+1 < argc)) {
+            horas = atof (argv[++i]);
+        } else if ((strcmp (argv[i], "-t") == 0) && (i+1 < argc)) {
+            nThreads = atoi (argv[++i]);
+        } else if ((strcmp (argv[i], "-s") == 0) && (i+1 < argc)) {
+            semente = (uint32_t) atol (argv[++i]);
+        } else if ((strcmp (argv[i], "-m") == 0) && (i+1 < argc)) {
+            i++;
+            modo = (strcmp (argv[i], "histerese") == 0) ? CTL_HISTERESE :
+                   (strcmp (argv[i], "pid") == 0) ? CTL_PID :
+                   (strcmp (argv[i], "autotune") == 0) ? CTL_AUTOTUNE :
+                   (strcmp (argv[i], "antecipa") == 0) ? CTL_ANTECIPA :
+                   (strcmp (argv[i], "misto") == 0) ? MODO_MISTO : -2;
+        } else if (strcmp (argv[i], "-v") == 0) {
+            verboso = true;
+        } else {
+            modo = -2;
+        }
+        if ((modo == -2) || (n <= 0) || (horas <= 0.0)) {
+            fprintf (stderr, "uso: frota [-n termostatos] [-h horas] [-t threads] [-s semente]\n"
+                             "            [-m histerese|pid|autotune|antecipa|misto] [-v]\n");
+            return 1;
+        }
+    }
+    if (nThreads < 1) {
+        nThreads = 1;
+    }
+
+    // Monta os ambientes e divide em blocos entre as threads
+    salas.resize (n);
+    for (int i = 0; i < n; i++) {
+        montaSala (&salas[i], semente + (uint32_t) i * 7919, modo);
+    }
+    for (int i = 0; i < nThreads; i++) {
+        TRABALHADOR *t = new TRABALHADOR;
+        t->executados = t->roubados = 0;
+        for (int j = (i * n) / nThreads; j < ((i + 1) * n) / nThreads; j++) {
+            t->fila.push_back (j);
+        }
+        trab.push_back (t);
+    }
+
+    struct timespec t0, t1;
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nThreads; i++) {
+        threads.push_back (std::thread (trabalha, i));
+    }
+    trabalha (0);
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    double seg = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    if (verboso) {
+        printf ("sala modo       liga desl  conforto  frio(Gh) calor(Gh) trocas/h ciclo\n");
+        for (int i = 0; i < n; i++) {
+            SALA *s = &salas[i];
+            printf ("%4d %-10s %4d %4d  %7.1f%% %9.2f %9.2f %8.2f %4.0f%%\n", i, nomeModo[s->modo],
+                    s->termo.tempLiga, s->termo.tempDesliga, 100.0 * s->conforto,
+                    s->grauHoraFrio, s->grauHoraCalor, s->trocasHora, 100.0 * s->ciclo);
+        }
+    }
+
+    double horasAnalise = (horas > AQUECIMENTO) ? horas - AQUECIMENTO : horas;
+    printf ("Termostatos: %d, %.1f h cada (estatisticas das ultimas %.1f h)\n", n, horas, horasAnalise);
+    for (int m = CTL_HISTERESE; m <= CTL_ANTECIPA; m++) {
+        int qtd = 0, curtas = 0, ajustou = 0;
+        for (int i = 0; i < n; i++) {
+            if (salas[i].modo == m) {
+                qtd++;
+                if (salas[i].trocasHora > TROCAS_CURTAS) {
+                    curtas++;
+                }
+                if (salas[i].termo.controle.at.concluida) {
+                    ajustou++;
+                }
+            }
+        }
+        if (qtd == 0) {
+            continue;
+        }
+        printf ("%s: %d termostatos", nomeModo[m], qtd);
+        if (m == CTL_AUTOTUNE) {
+            printf (", %d com auto-sintonia concluida", ajustou);
+        }
+        printf (", %d com mais de %.0f trocas/h\n", curtas, TROCAS_CURTAS);
+        mostraCampo ("conforto (%)", m, offsetof(SALA, conforto), 100.0, "%6.1f");
+        mostraCampo ("frio (grau*h)", m, offsetof(SALA, grauHoraFrio), 1.0, "%6.2f");
+        mostraCampo ("calor (grau*h)", m, offsetof(SALA, grauHoraCalor), 1.0, "%6.2f");
+        mostraCampo ("trocas do rele por h", m, offsetof(SALA, trocasHora), 1.0, "%6.2f");
+        mostraCampo ("ciclo de trabalho (%)", m, offsetof(SALA, ciclo), 100.0, "%6.1f");
+    }
+
+    long roubados = 0;
+    printf ("Threads: %d (termostatos por thread:", nThreads);
+    for (int i = 0; i < nThreads; i++) {
+        printf (" %ld", trab[i]->executados);
+        roubados += trab[i]->roubados;
+        delete trab[i];
+    }
+    printf ("), %ld roubados\n", roubados);
+    printf ("Tempo: %.2f s, %.0f horas simuladas/s\n", seg, n * horas / seg);
+    return 0;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file perifericos_host.h
+ * @author Daniel Quadros
+ * @brief Periféricos simulados, para usar no host no lugar de perifericos.h
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Os templates têm os mesmos nomes e a mesma interface dos drivers do
+ * firmware, especializados para a placa PlacaHost. O estado de cada
+ * periférico fica em memória e pode ser examinado pelas ferramentas.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef PERIFERICOS_H
+#define PERIFERICOS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PLACA PlacaHost
+#include "placa.h"
+#include "menu.h"
+
+// Display: guarda o texto de cada linha
+// (os dígitos dupla altura aparecem como caracteres na linha de cima)
+template <const CFG_DISPLAY &cfg>
+class Display {
+public:
+    static void init() {
+        clear();
+        refresh();
+    }
+    static void refresh() {
+        memcpy (mostrada, tela, sizeof(tela));
+    }
+    static void car(int l, int c, char ch) {
+        tela[l][c] = ch;
+    }
+    static void str(int l, int c, const char *txt) {
+        while (*txt) {
+            car (l, c, *txt++);
+            if (c < 11) {
+                c++;
+            } else {
+                c = 0;
+                l++;
+            }
+        }
+    }
+    static void digDD(int l, int c, int dig) {
+        tela[l][c] = (char) ('0' + dig);
+        tela[l][c+1] = ' ';
+    }
+    static void clear() {
+        memset (tela, ' ', sizeof(tela));
+        for (int l = 0; l < 6; l++) {
+            tela[l][12] = 0;
+        }
+    }
+    // Linha da última tela enviada ao display
+    static const char *linha(int l) {
+        return mostrada[l];
+    }
+
+private:
+    static inline char tela[6][13];
+    static inline char mostrada[6][13];
+};
+
+// EEPROM: memória do tamanho do tipo configurado, apagada (0xFF) no início
+// Conta as gravações de página, que no firmware custam até 5 ms cada
+template <const CFG_EEPROM &cfg>
+class Eeprom {
+public:
+    static constexpr EEPROM_TIPO tipo = EEPROM_TIPOS[cfg.tipo];
+
+    static void init() {
+        memset (mem, 0xFF, sizeof(mem));
+        nGravacoes = 0;
+    }
+    static uint32_t tamanho() {
+        return tipo.tamanho;
+    }
+    static int pagina() {
+        return tipo.pagina;
+    }
+    static bool read(uint8_t *buffer, uint32_t addr, int n) {
+        if ((addr + n) > tipo.tamanho) {
+            return false;
+        }
+        memcpy (buffer, mem + addr, n);
+        return true;
+    }
+    static bool write(const uint8_t *buffer, uint32_t addr, int n) {
+        if ((addr + n) > tipo.tamanho) {
+            return false;
+        }
+        memcpy (mem + addr, buffer, n);
+        while (n > 0) {
+            int nWrt = tipo.pagina - (addr % tipo.pagina);
+            if (nWrt > n) {
+                nWrt = n;
+            }
+            nGravacoes++;
+            addr += nWrt;
+            n -= nWrt;
+        }
+        return true;
+    }
+    static inline long nGravacoes = 0;
+
+private:
+    static inline uint8_t mem[tipo.tamanho];
+};
+
+// Relê: guarda o estado e conta as trocas
+template <const CFG_RELE &cfg>
+class Rele {
+public:
+    static void init(bool ligado) {
+        estado = ligado;
+        nTrocas = 0;
+    }
+    static void aciona(bool ligado) {
+        if (ligado != estado) {
+            nTrocas++;
+        }
+        estado = ligado;
+    }
+    static bool ligado() {
+        return estado;
+    }
+    static inline long nTrocas = 0;
+
+private:
+    static inline bool estado = false;
+};
+
+// Encoder: as teclas são injetadas pela simulação
+template <const CFG_ENCODER &cfg>
+class Encoder {
+public:
+    static const int T_FILA = 32;
+
+    static void init() {
+        poe = tira = 0;
+    }
+    static void poeTecla(int tecla) {
+        int prox = (poe + 1) % T_FILA;
+        if (prox != tira) {
+            fila[poe] = tecla;
+            poe = prox;
+        }
+    }
+    static bool temTecla() {
+        return tira != poe;
+    }
+    static int tecLe() {
+        if (tira == poe) {
+            return -1;
+        }
+        int tecla = fila[tira];
+        tira = (tira + 1) % T_FILA;
+        return tecla;
+    }
+
+private:
+    static inline int fila[T_FILA];
+    static inline int poe, tira;
+};
+
+typedef Display<PLACA::display> TELA;
+typedef Eeprom<PLACA::eeprom> EEPROM;
+typedef Rele<PLACA::rele> RELE;
+typedef Encoder<PLACA::encoder> ENCODER;
+
+#endif
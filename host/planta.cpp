@@ -0,0 +1,69 @@
+/**
+ * @file planta.cpp
+ * @author Daniel Quadros
+ * @brief Modelo térmico simples de um ambiente com aquecedor, para simulação
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * São dois acumuladores de calor (aquecedor e ambiente) mais um
+ * tempo morto entre o relê e o aquecedor. O calor acumulado no
+ * aquecedor continua passando para o ambiente depois que o relê
+ * desliga, que é o que causa o "overshoot" da histerese simples.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "controle.h"
+#include "planta.h"
+
+// Preenche os parâmetros padrão (sala com aquecedor elétrico)
+void plantaParamPadrao (PLANTA_PARAM *par) {
+    par->tempExterna = 10.0;
+    par->perda = 1.0/3600.0;
+    par->potencia = 25.0/3600.0/0.2;
+    par->acoplamento = 1.0/900.0;
+    par->massaAquecedor = 0.2;
+    par->atraso = 30.0;
+    par->ruido = 0.05;
+}
+
+// Inicia o modelo, com ambiente e aquecedor na temperatura indicada
+void plantaInit (PLANTA *pl, const PLANTA_PARAM *par, double temp, double dt) {
+    memset (pl, 0, sizeof(PLANTA));
+    pl->par = *par;
+    pl->tempAmbiente = temp;
+    pl->tempAquecedor = temp;
+    pl->nFila = (int) (par->atraso / dt);
+    if (pl->nFila < 1) {
+        pl->nFila = 1;
+    } else if (pl->nFila > MAX_ATRASO) {
+        pl->nFila = MAX_ATRASO;
+    }
+    pl->semente = 12345;
+}
+
+// Avança a simulação dt segundos com o relê no estado indicado
+void plantaPasso (PLANTA *pl, bool rele, double dt) {
+    PLANTA_PARAM *par = &pl->par;
+
+    // Aplica o tempo morto
+    bool aquece = pl->fila[pl->pos];
+    pl->fila[pl->pos] = rele;
+    pl->pos = (pl->pos + 1) % pl->nFila;
+
+    double troca = par->acoplamento * (pl->tempAquecedor - pl->tempAmbiente);
+    double perda = par->perda * (pl->tempAmbiente - par->tempExterna);
+    pl->tempAquecedor += dt * ((aquece ? par->potencia : 0.0) - troca / par->massaAquecedor);
+    pl->tempAmbiente += dt * (troca - perda);
+}
+
+// Leitura do sensor, em 1/16 de grau
+int32_t plantaSensor (PLANTA *pl) {
+    pl->semente = pl->semente * 1103515245 + 12345;
+    double ruido = pl->par.ruido * ((double) ((pl->semente >> 16) & 0x7FFF) / 16384.0 - 1.0);
+    return (int32_t) lround ((pl->tempAmbiente + ruido) * TEMP_ESCALA);
+}
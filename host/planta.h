@@ -0,0 +1,54 @@
+/**
+ * @file planta.h
+ * @author Daniel Quadros
+ * @brief Modelo térmico simples de um ambiente com aquecedor, para simulação
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef PLANTA_H
+#define PLANTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_ATRASO 1024     // passos de atraso armazenados
+
+// Parâmetros do modelo
+typedef struct {
+    double tempExterna;     // temperatura externa (graus)
+    double perda;           // perda do ambiente para o exterior (1/s)
+    double potencia;        // potência do aquecedor (graus/s no aquecedor)
+    double acoplamento;     // troca de calor aquecedor -> ambiente (1/s)
+    double massaAquecedor;  // massa térmica do aquecedor relativa ao ambiente
+    double atraso;          // tempo morto entre o relê e o aquecedor (s)
+    double ruido;           // ruído do sensor (graus, pico)
+} PLANTA_PARAM;
+
+// Estado do modelo
+typedef struct {
+    PLANTA_PARAM par;
+    double tempAmbiente;
+    double tempAquecedor;
+    bool fila[MAX_ATRASO];  // estados do relê ainda não aplicados
+    int nFila;
+    int pos;
+    uint32_t semente;       // gerador do ruído
+} PLANTA;
+
+// Preenche os parâmetros padrão (sala com aquecedor elétrico)
+void plantaParamPadrao (PLANTA_PARAM *par);
+
+// Inicia o modelo, com ambiente e aquecedor na temperatura indicada
+void plantaInit (PLANTA *pl, const PLANTA_PARAM *par, double temp, double dt);
+
+// Avança a simulação dt segundos com o relê no estado indicado
+void plantaPasso (PLANTA *pl, bool rele, double dt);
+
+// Leitura do sensor, em 1/16 de grau
+int32_t plantaSensor (PLANTA *pl);
+
+#endif
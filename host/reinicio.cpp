@@ -0,0 +1,252 @@
+/**
+ * @file reinicio.cpp
+ * @author Daniel Quadros
+ * @brief Simulação de reinícios pelo watchdog em pontos aleatórios
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Uso: reinicio [pid|histerese] [horas] [reinicios por hora] [semente]
+ *
+ * Roda o controle contra o modelo térmico, salvando o estado a cada
+ * passo como no firmware. Em pontos aleatórios simula um reinício:
+ * antes do passo, entre a decisão e o salvamento ou no meio da cópia
+ * do estado. Após cada reinício o estado é recuperado da área
+ * preservada e comparado com o último estado salvo por completo.
+ * Depois do reinício o controle volta após a partida (relê restaurado)
+ * e uma conversão dos sensores, sem esperar a EEPROM (como no
+ * firmware); confere que o primeiro passo ocorre em até
+ * PRIMEIRO_PASSO_MS.
+ * Também confere que lixo na área (falta de energia) é rejeitado.
+ *
+ * Retorna 0 se todas as recuperações foram corretas.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "controle.h"
+#include "retomada.h"
+#include "agenda.h"
+#include "planta.h"
+
+#define DT_PLANTA       0.25    // passo da simulação do modelo (s)
+#define PASSOS_LEITURA  3       // uma leitura a cada 750 ms
+#define PASSOS_REINICIO 2       // relê desligado durante o reinício (500 ms)
+#define PRIMEIRO_PASSO_MS 1500  // limite do reinício até o primeiro passo
+
+// Pontos onde o reinício pode ocorrer
+#define PT_ANTES        0       // antes da leitura
+#define PT_DECIDIU      1       // depois da decisão, antes de salvar
+#define PT_SALVANDO     2       // no meio da cópia do estado
+#define N_PONTOS        3
+
+// Gerador pseudo-aleatório simples, para resultados repetíveis
+static uint32_t semente = 1;
+static uint32_t aleatorio (void) {
+    semente = semente * 1103515245 + 12345;
+    return (semente >> 8) & 0xFFFFFF;
+}
+
+// Simula uma área de RAM sem iniciação (falta de energia)
+static void encheLixo (AREA_RETOMADA *area) {
+    uint8_t *p = (uint8_t *) area;
+    for (size_t i = 0; i < sizeof(AREA_RETOMADA); i++) {
+        p[i] = (uint8_t) aleatorio();
+    }
+}
+
+// Roda a simulação; se nReinicios > 0 simula reinícios aleatórios
+// Retorna o número de falhas de recuperação
+static int simula (int modo, double horas, double porHora, double *erroMedio, int *trocas,
+                   int *nReinicios, int *nPontos, uint32_t *maxPrimeiro) {
+    PLANTA_PARAM par;
+    PLANTA planta;
+    plantaParamPadrao (&par);
+    plantaInit (&planta, &par, 15.0, DT_PLANTA);
+
+    // Estado do "firmware": perdido a cada reinício, exceto a área
+    CONTROLE ctl;
+    AREA_RETOMADA area;
+    uint32_t seq = 0;
+    ESTADO_CTL ultimo;          // último estado salvo por completo
+    bool temUltimo = false;
+    bool rele = false;
+    uint32_t base = 0;          // o relógio do RP2040 volta a zero no reinício
+    int falhas = 0;
+
+    retomadaInvalida (&area);
+    controleInit (&ctl, modo);
+    controleSetPoints (&ctl, 20, 22);
+
+    long nPassos = (long) (horas * 3600.0 / DT_PLANTA);
+    double pReinicio = porHora * PASSOS_LEITURA * DT_PLANTA / 3600.0;
+    double somaErro = 0.0;
+    int parado = 0;             // passos restantes com o firmware reiniciando
+    long proxLeitura = 0;       // passo da próxima leitura
+    long iReinicio = -1;        // passo do último reinício, até o primeiro passo
+    *maxPrimeiro = 0;
+    *trocas = 0;
+    *nReinicios = 0;
+
+    for (long i = 0; i < nPassos; i++) {
+        if ((parado == 0) && (i >= proxLeitura)) {
+            proxLeitura = i + PASSOS_LEITURA;
+            if (iReinicio >= 0) {
+                // Primeiro passo depois do reinício
+                uint32_t ms = (uint32_t) ((i - iReinicio) * DT_PLANTA * 1000.0);
+                if (ms > *maxPrimeiro) {
+                    *maxPrimeiro = ms;
+                }
+                if (ms > PRIMEIRO_PASSO_MS) {
+                    printf ("Falha: primeiro passo %lu ms depois do reinicio no passo %ld\n",
+                            (unsigned long) ms, iReinicio);
+                    falhas++;
+                }
+                iReinicio = -1;
+            }
+            uint32_t agora = (uint32_t) (i * DT_PLANTA * 1000.0) - base;
+            int ponto = -1;
+            if ((aleatorio() / (double) 0x1000000) < pReinicio) {
+                ponto = aleatorio() % N_PONTOS;
+                nPontos[ponto]++;
+            }
+
+            if (ponto != PT_ANTES) {
+                int32_t leitura = plantaSensor (&planta);
+                bool novo = controlePasso (&ctl, leitura, agora);
+                if (novo != rele) {
+                    (*trocas)++;
+                    rele = novo;
+                }
+                if (ponto != PT_DECIDIU) {
+                    ESTADO_CTL est;
+                    est.temp = leitura;
+                    est.tempLiga = 20;
+                    est.tempDesliga = 22;
+                    est.ligado = rele;
+                    est.agora = agora;
+                    est.relogio = (int32_t) (agora / 1000 % (MIN_SEMANA*60));
+                    est.controle = ctl;
+                    if (ponto == PT_SALVANDO) {
+                        // Só parte da cópia chega à RAM
+                        AREA_RETOMADA completa = area;
+                        uint32_t seqAux = seq;
+                        retomadaSalva (&completa, &seqAux, &est);
+                        CHECKPOINT *dst = &area.copia[seqAux & 1];
+                        size_t n = aleatorio() % sizeof(CHECKPOINT);
+                        memcpy (dst, &completa.copia[seqAux & 1], n);
+                    } else {
+                        retomadaSalva (&area, &seq, &est);
+                        ultimo = est;
+                        temUltimo = true;
+                    }
+                }
+            }
+
+            if (ponto >= 0) {
+                // Reinício: perde tudo menos a área, relê desliga
+                (*nReinicios)++;
+                memset (&ctl, 0x55, sizeof(ctl));
+                seq = 12345;
+                rele = false;
+                parado = PASSOS_REINICIO;
+                iReinicio = i;
+
+                // O core 1 é iniciado logo depois de restaurar o relê;
+                // o primeiro passo é depois de uma conversão
+                proxLeitura = i + PASSOS_REINICIO + PASSOS_LEITURA;
+
+                // Recupera, já com a nova base de tempo
+                uint32_t agoraNovo = 0;
+                base = (uint32_t) ((i + PASSOS_REINICIO) * DT_PLANTA * 1000.0);
+                ESTADO_CTL est;
+                if (!retomadaRestaura (&area, &est, &seq)) {
+                    if (temUltimo) {
+                        printf ("Falha: estado nao recuperado no passo %ld\n", i);
+                        falhas++;
+                    }
+                    controleInit (&ctl, modo);
+                    controleSetPoints (&ctl, 20, 22);
+                } else {
+                    if (memcmp(&est.controle, &ultimo.controle, sizeof(CONTROLE)) ||
+                        (est.ligado != ultimo.ligado) || (est.agora != ultimo.agora) ||
+                        (est.relogio != ultimo.relogio)) {
+                        printf ("Falha: estado recuperado diferente do ultimo salvo no passo %ld\n", i);
+                        falhas++;
+                    }
+                    ctl = est.controle;
+                    controleAjustaTempo (&ctl, agoraNovo - est.agora);
+                    rele = est.ligado;
+                }
+            }
+        }
+        plantaPasso (&planta, (parado > 0) ? false : rele, DT_PLANTA);
+        if (parado > 0) {
+            parado--;
+        }
+        if (i >= nPassos / 2) {
+            double erro = planta.tempAmbiente - 21.0;
+            somaErro += (erro < 0) ? -erro : erro;
+        }
+    }
+    *erroMedio = somaErro / (nPassos - nPassos / 2);
+    return falhas;
+}
+
+int main(int argc, char *argv[]) {
+    int modo = CTL_PID;
+    double horas = 48.0;
+    double porHora = 20.0;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "histerese") == 0) {
+            modo = CTL_HISTERESE;
+        } else if (strcmp(argv[1], "pid") != 0) {
+            fprintf (stderr, "uso: reinicio [pid|histerese] [horas] [reinicios por hora] [semente]\n");
+            return 1;
+        }
+    }
+    if (argc > 2) {
+        horas = atof(argv[2]);
+    }
+    if (argc > 3) {
+        porHora = atof(argv[3]);
+    }
+    if (argc > 4) {
+        semente = (uint32_t) atol(argv[4]);
+    }
+
+    // Lixo na área deve ser rejeitado
+    int aceitos = 0;
+    for (int i = 0; i < 100000; i++) {
+        AREA_RETOMADA area;
+        ESTADO_CTL est;
+        uint32_t seq;
+        encheLixo (&area);
+        if (retomadaRestaura (&area, &est, &seq)) {
+            aceitos++;
+        }
+    }
+    printf ("Areas com lixo aceitas: %d de 100000\n", aceitos);
+
+    // Referência sem reinícios e simulação com reinícios
+    double erroRef, erro;
+    int trocasRef, trocas, nReinicios;
+    int nPontos[N_PONTOS] = {0, 0, 0};
+    uint32_t maxPrimeiro;
+    simula (modo, horas, 0.0, &erroRef, &trocasRef, &nReinicios, nPontos, &maxPrimeiro);
+    int falhas = simula (modo, horas, porHora, &erro, &trocas, &nReinicios, nPontos, &maxPrimeiro);
+
+    printf ("Reinicios: %d (antes do passo %d, antes de salvar %d, durante o salvamento %d)\n",
+            nReinicios, nPontos[PT_ANTES], nPontos[PT_DECIDIU], nPontos[PT_SALVANDO]);
+    printf ("Recuperacoes com falha: %d\n", falhas);
+    printf ("Maior tempo ate o primeiro passo: %lu ms (limite %d ms)\n",
+            (unsigned long) maxPrimeiro, PRIMEIRO_PASSO_MS);
+    printf ("Erro medio em regime: %.3f sem reinicios, %.3f com reinicios\n", erroRef, erro);
+    printf ("Trocas do rele: %d sem reinicios, %d com reinicios\n", trocasRef, trocas);
+    return ((falhas == 0) && (aceitos == 0)) ? 0 : 1;
+}
@@ -0,0 +1,1020 @@
+/**
+ * @file replay.cpp
+ * @author Daniel Quadros
+ * @brief Reprodução de trajetórias de temperatura e teclas contra a
+ *        lógica de controle e de configuração do firmware
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Uso: replay [-n cenarios] [-h horas] [-s semente] [-v] [arquivo ...]
+ *
+ * Passa leituras de temperatura (a cada 750 ms, como no firmware) por
+ * termostato.cpp e sequências de teclas por menu.cpp, conferindo:
+ *   - na histerese, cada decisão do relê contra uma implementação
+ *     independente (a decisão tem que sair na mesma leitura)
+ *   - no PID, os tempos mínimos ligado/desligado e que o relê reage
+ *     a um erro grande dentro de duas janelas
+ *   - na antecipação, os tempos mínimos e que a troca nunca é mais
+ *     tarde que pela leitura comparada diretamente com os set points
+ *     (passado o tempo mínimo, desliga até a leitura em que atinge
+ *     "Desliga" e liga até a leitura em que atinge "Liga")
+ *   - na configuração, que os set points ficam na faixa, que só
+ *     mudam dentro da configuração e que a configuração é salva ao
+ *     sair se, e somente se, houve alteração
+ *   - na edição da agenda (as teclas na página da agenda vão para
+ *     menuAgenda, como no firmware), que as entradas continuam
+ *     válidas, que cada tecla muda um campo da entrada selecionada em
+ *     um passo, a seleção das entradas e que a agenda é salva (e passa
+ *     a valer) ao sair se, e somente se, houve alteração
+ *   - na agenda, a cada minuto, que a transição em vigor (e se ela
+ *     mudou) confere com uma procura independente nas entradas,
+ *     inclusive quando o relógio é acertado para frente ou para trás
+ *   - as expectativas dos arquivos (trocas, configuração salva,
+ *     número de salvamentos e set points no final)
+ *
+ * Sem arquivos, roda cenários sintéticos (rampa, senoide, degrau e
+ * passeio aleatório, com teclas aleatórias e, em metade deles, uma
+ * agenda e acertos aleatórios do relógio); o cenário k usa a semente
+ * s+k, portanto "-s <s+k> -n 1" repete só ele. O instante inicial é
+ * aleatório para exercitar a volta do relógio de 32 bits.
+ *
+ * Os arquivos têm uma diretiva por linha (instantes em segundos):
+ *   modo histerese|pid|antecipa
+ *   setpoints <liga> <desliga>
+ *   T <s> <temperatura>        (interpolada entre os pontos)
+ *   K <s> enter|up|dn
+ *   agenda <n> <dias> <hh:mm> <liga> <desliga>   (como no comando)
+ *   H <s> dom|seg|ter|qua|qui|sex|sab <hh:mm>    (acerta o relógio)
+ *   E trocas <min> <max>
+ *   E config <liga> <desliga>
+ *   E salvas <n>
+ *   E salvas agenda <n>
+ *   E setpoints <liga> <desliga>
+ * Também aceita o CSV gerado pelo teldec a partir de uma captura: os
+ * registros temp e tecla são reproduzidos, os registros agenda mudam
+ * os set points no mesmo instante (como uma transição da agenda, sem
+ * contar como salvamento), os registros config e rele dão a
+ * configuração esperada e o número de salvamentos e trocas.
+ *
+ * Retorna 0 se todos os cenários passaram.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "termostato.h"
+#include "menu.h"
+
+#define DT_LEITURA      750     // intervalo entre leituras (ms)
+#define N_PADRAO        2000    // cenários sintéticos
+#define HORAS_PADRAO    6.0     // duração de cada cenário sintético
+#define ERRO_GRANDE     (4*TEMP_ESCALA)     // erro que o PID não pode ignorar
+#define MAX_FALHAS      5       // falhas apresentadas por cenário
+
+// Trajetórias sintéticas
+#define TR_RAMPA        0
+#define TR_SENOIDE      1
+#define TR_DEGRAU       2
+#define TR_PASSEIO      3
+#define N_TRAJ          4
+
+static const char *nomeTraj[N_TRAJ] = { "rampa", "senoide", "degrau", "passeio" };
+
+// Nome do modo de controle, como no comando "modo"
+static const char *nomeModo (int modo) {
+    return (modo == CTL_PID) ? "pid" : (modo == CTL_ANTECIPA) ? "antecipa" : "histerese";
+}
+
+// Dias da semana, como no comando "hora"
+static const char *nomeDia[7] = { "dom", "seg", "ter", "qua", "qui", "sex", "sab" };
+
+// Ponto de uma trajetória gravada
+typedef struct {
+    uint32_t t;         // ms
+    double temp;        // graus
+} PONTO;
+
+// Tecla em um instante
+typedef struct {
+    uint32_t t;         // ms
+    int tecla;
+} EVTECLA;
+
+// Acerto do relógio em um instante
+typedef struct {
+    uint32_t t;         // ms
+    int minSemana;
+} EVHORA;
+
+// Set points aplicados pela agenda em um instante (captura)
+typedef struct {
+    uint32_t t;         // ms
+    int liga, desliga;
+} EVAGENDA;
+
+// Um cenário a reproduzir
+typedef struct {
+    char nome[64];
+    int modo;
+    int liga, desliga;
+    uint32_t duracao;   // ms
+    uint32_t base;      // instante inicial do relógio (ms)
+
+    // Trajetória sintética
+    int traj;
+    double tempBase, ampl, periodo;     // graus, graus, s
+    uint32_t semente;
+
+    // Trajetória gravada
+    PONTO *pontos;
+    int nPontos, maxPontos;
+
+    EVTECLA *teclas;
+    int nTeclas, maxTeclas;
+
+    // Agenda e acertos do relógio
+    AGENDA agenda;
+    EVHORA *horas;
+    int nHoras, maxHoras;
+    EVAGENDA *capAgenda;
+    int nCapAgenda, maxCapAgenda;
+
+    // Expectativas (-1 = não confere)
+    int trocasMin, trocasMax;
+    int cfgLiga, cfgDesliga;
+    int salvas;
+    int salvasAgenda;
+    int spLiga, spDesliga;
+} CENARIO;
+
+// Resultado de um cenário
+typedef struct {
+    int falhas;
+    long leituras;
+    int trocas;
+    int salvas;
+    int teclas;
+    int agendadas;      // transições da agenda aplicadas
+    int salvasAgenda;
+} RESULTADO;
+
+static bool verboso = false;
+
+// A agenda (usada pela configuração, em menu.cpp) acessa a EEPROM,
+// que não existe no replay
+bool appEepromLe (uint8_t *, uint32_t, int) {
+    return false;
+}
+
+bool appEepromGrava (const uint8_t *, uint32_t, int) {
+    return false;
+}
+
+// Gerador pseudo-aleatório simples, para resultados repetíveis
+static uint32_t aleatorio (uint32_t *sem) {
+    *sem = *sem * 1103515245 + 12345;
+    return (*sem >> 8) & 0xFFFFFF;
+}
+
+// Valor aleatório entre min e max
+static double faixa (uint32_t *sem, double min, double max) {
+    return min + (max - min) * (aleatorio(sem) / (double) 0x1000000);
+}
+
+// Registra uma falha no cenário
+static void falha (const CENARIO *c, RESULTADO *res, uint32_t t, const char *msg) {
+    if (res->falhas < MAX_FALHAS) {
+        printf ("FALHA %s em %.2f s: %s\n", c->nome, t / 1000.0, msg);
+    }
+    res->falhas++;
+}
+
+// Acrescenta um ponto à trajetória gravada
+static void poePonto (CENARIO *c, uint32_t t, double temp) {
+    if (c->nPontos == c->maxPontos) {
+        c->maxPontos = c->maxPontos ? 2*c->maxPontos : 256;
+        c->pontos = (PONTO *) realloc (c->pontos, c->maxPontos * sizeof(PONTO));
+    }
+    c->pontos[c->nPontos].t = t;
+    c->pontos[c->nPontos].temp = temp;
+    c->nPontos++;
+}
+
+// Acrescenta uma tecla ao cenário
+static void poeTecla (CENARIO *c, uint32_t t, int tecla) {
+    if (c->nTeclas == c->maxTeclas) {
+        c->maxTeclas = c->maxTeclas ? 2*c->maxTeclas : 64;
+        c->teclas = (EVTECLA *) realloc (c->teclas, c->maxTeclas * sizeof(EVTECLA));
+    }
+    c->teclas[c->nTeclas].t = t;
+    c->teclas[c->nTeclas].tecla = tecla;
+    c->nTeclas++;
+}
+
+// Acrescenta um acerto do relógio ao cenário
+static void poeHora (CENARIO *c, uint32_t t, int minSemana) {
+    if (c->nHoras == c->maxHoras) {
+        c->maxHoras = c->maxHoras ? 2*c->maxHoras : 16;
+        c->horas = (EVHORA *) realloc (c->horas, c->maxHoras * sizeof(EVHORA));
+    }
+    c->horas[c->nHoras].t = t;
+    c->horas[c->nHoras].minSemana = minSemana;
+    c->nHoras++;
+}
+
+// Acrescenta uma transição da agenda capturada ao cenário
+static void poeCapAgenda (CENARIO *c, uint32_t t, int liga, int desliga) {
+    if (c->nCapAgenda == c->maxCapAgenda) {
+        c->maxCapAgenda = c->maxCapAgenda ? 2*c->maxCapAgenda : 16;
+        c->capAgenda = (EVAGENDA *) realloc (c->capAgenda, c->maxCapAgenda * sizeof(EVAGENDA));
+    }
+    c->capAgenda[c->nCapAgenda].t = t;
+    c->capAgenda[c->nCapAgenda].liga = liga;
+    c->capAgenda[c->nCapAgenda].desliga = desliga;
+    c->nCapAgenda++;
+}
+
+static void iniciaCenario (CENARIO *c) {
+    memset (c, 0, sizeof(CENARIO));
+    c->modo = CTL_HISTERESE;
+    c->liga = 20;
+    c->desliga = 22;
+    c->traj = -1;
+    c->trocasMin = c->trocasMax = -1;
+    c->cfgLiga = c->cfgDesliga = -1;
+    c->salvas = c->salvasAgenda = -1;
+    c->spLiga = c->spDesliga = -1;
+    agendaPadrao (&c->agenda);
+}
+
+static void liberaCenario (CENARIO *c) {
+    free (c->pontos);
+    free (c->teclas);
+    free (c->horas);
+    free (c->capAgenda);
+}
+
+// Monta um cenário sintético a partir da semente
+static void geraCenario (CENARIO *c, uint32_t semente, double horas) {
+    iniciaCenario (c);
+    uint32_t sem = semente;
+    snprintf (c->nome, sizeof(c->nome), "sintetico %u", semente);
+    c->semente = semente;
+    c->duracao = (uint32_t) (horas * 3600000.0);
+    c->base = aleatorio(&sem) << 8;
+    uint32_t m = aleatorio(&sem) % 3;
+    c->modo = (m == 0) ? CTL_HISTERESE : (m == 1) ? CTL_PID : CTL_ANTECIPA;
+    c->liga = 15 + aleatorio(&sem) % 10;
+    c->desliga = c->liga + 1 + aleatorio(&sem) % 3;
+    c->traj = aleatorio(&sem) % N_TRAJ;
+    c->tempBase = faixa (&sem, c->liga - 3.0, c->desliga + 3.0);
+    c->ampl = faixa (&sem, 0.5, 8.0);
+
+    // A variação fica abaixo de 2 graus por minuto, como num ambiente
+    double minimo = 2.0 * M_PI * c->ampl * 30.0;
+    c->periodo = faixa (&sem, minimo, 6.0 * 3600.0);
+    if (c->periodo < 600.0) {
+        c->periodo = 600.0;
+    }
+
+    // Teclas aleatórias, em média uma a cada 4 minutos
+    uint32_t t = 0;
+    while (true) {
+        t += (uint32_t) faixa (&sem, 1000.0, 480000.0);
+        if (t >= c->duracao) {
+            break;
+        }
+        uint32_t r = aleatorio(&sem) % 10;
+        poeTecla (c, t, (r < 3) ? TECLA_ENTER : (r < 7) ? TECLA_UP : TECLA_DN);
+
+        // Às vezes uma rajada, como girando o encoder
+        if ((aleatorio(&sem) % 4) == 0) {
+            int tecla = (aleatorio(&sem) & 1) ? TECLA_UP : TECLA_DN;
+            int n = 1 + aleatorio(&sem) % 20;
+            for (int i = 0; (i < n) && (t < c->duracao); i++) {
+                t += 20 + aleatorio(&sem) % 100;
+                poeTecla (c, t, tecla);
+            }
+        }
+    }
+
+    // Em metade dos cenários, uma agenda com algumas entradas e o
+    // relógio acertado no início e, em média, a cada duas horas (para
+    // qualquer minuto da semana, exercitando saltos para frente e para
+    // trás)
+    if (aleatorio(&sem) & 1) {
+        int n = 1 + aleatorio(&sem) % 4;
+        for (int i = 0; i < n; i++) {
+            ENTRADA_AGENDA *e = &c->agenda.ent[aleatorio(&sem) % AGENDA_MAX];
+            e->dias = (uint8_t) (1 + aleatorio(&sem) % AGENDA_TODOS);
+            e->minuto = (uint16_t) (aleatorio(&sem) % MIN_DIA);
+            e->liga = (int8_t) (15 + aleatorio(&sem) % 10);
+            e->desliga = (int8_t) (e->liga + 1 + aleatorio(&sem) % 3);
+        }
+        t = 0;
+        while (t < c->duracao) {
+            poeHora (c, t, (int) (aleatorio(&sem) % MIN_SEMANA));
+            t += (uint32_t) faixa (&sem, 60000.0, 4.0 * 3600000.0);
+        }
+    }
+}
+
+// Lê um cenário de um arquivo
+static bool leCenario (CENARIO *c, const char *arquivo) {
+    iniciaCenario (c);
+    FILE *arq = fopen (arquivo, "r");
+    if (arq == NULL) {
+        perror (arquivo);
+        return false;
+    }
+    snprintf (c->nome, sizeof(c->nome), "%s", arquivo);
+
+    char linha[128];
+    int nLinha = 0;
+    int trocasCSV = 0;
+    bool csv = false;
+    bool ok = true;
+    while (ok && (fgets (linha, sizeof(linha), arq) != NULL)) {
+        char txt[16];
+        double s, val;
+        int a, b, d, h, m;
+        nLinha++;
+        if ((linha[0] == '#') || (linha[0] == '\n') || (linha[0] == '\r')) {
+            continue;
+        }
+        if (sscanf (linha, "modo %15s", txt) == 1) {
+            if (strcmp (txt, "pid") == 0) {
+                c->modo = CTL_PID;
+            } else if (strcmp (txt, "histerese") == 0) {
+                c->modo = CTL_HISTERESE;
+            } else if (strcmp (txt, "antecipa") == 0) {
+                c->modo = CTL_ANTECIPA;
+            } else {
+                ok = false;
+            }
+        } else if (sscanf (linha, "setpoints %d %d", &a, &b) == 2) {
+            c->liga = a;
+            c->desliga = b;
+        } else if (sscanf (linha, "T %lf %lf", &s, &val) == 2) {
+            poePonto (c, (uint32_t) (s * 1000.0), val);
+        } else if (sscanf (linha, "K %lf %15s", &s, txt) == 2) {
+            int tecla = (strcmp (txt, "enter") == 0) ? TECLA_ENTER :
+                        (strcmp (txt, "up") == 0) ? TECLA_UP :
+                        (strcmp (txt, "dn") == 0) ? TECLA_DN : -1;
+            if (tecla < 0) {
+                ok = false;
+            } else {
+                poeTecla (c, (uint32_t) (s * 1000.0), tecla);
+            }
+        } else if (sscanf (linha, "agenda %d %15s %d:%d %d %d", &a, txt, &h, &m, &b, &d) == 6) {
+            ENTRADA_AGENDA e;
+            e.minuto = (uint16_t) (h*60 + m);
+            e.liga = (int8_t) b;
+            e.desliga = (int8_t) d;
+            if ((a < 0) || (a >= AGENDA_MAX) || (h < 0) || (h > 23) || (m < 0) || (m > 59) ||
+                !agendaLeDias (txt, &e.dias) || !agendaValida (&e)) {
+                ok = false;
+            } else {
+                c->agenda.ent[a] = e;
+            }
+        } else if (sscanf (linha, "H %lf %15s %d:%d", &s, txt, &h, &m) == 4) {
+            int dia = 0;
+            while ((dia < 7) && (strcmp (txt, nomeDia[dia]) != 0)) {
+                dia++;
+            }
+            if ((dia == 7) || (h < 0) || (h > 23) || (m < 0) || (m > 59)) {
+                ok = false;
+            } else {
+                poeHora (c, (uint32_t) (s * 1000.0), dia*MIN_DIA + h*60 + m);
+            }
+        } else if (sscanf (linha, "E trocas %d %d", &a, &b) == 2) {
+            c->trocasMin = a;
+            c->trocasMax = b;
+        } else if (sscanf (linha, "E config %d %d", &a, &b) == 2) {
+            c->cfgLiga = a;
+            c->cfgDesliga = b;
+        } else if (sscanf (linha, "E salvas agenda %d", &a) == 1) {
+            c->salvasAgenda = a;
+        } else if (sscanf (linha, "E salvas %d", &a) == 1) {
+            c->salvas = a;
+        } else if (sscanf (linha, "E setpoints %d %d", &a, &b) == 2) {
+            c->spLiga = a;
+            c->spDesliga = b;
+        } else if (sscanf (linha, "%lf,temp,%lf", &s, &val) == 2) {
+            poePonto (c, (uint32_t) (s * 1000.0), val);
+            csv = true;
+        } else if (sscanf (linha, "%lf,tecla,%d", &s, &a) == 2) {
+            poeTecla (c, (uint32_t) (s * 1000.0), a);
+            csv = true;
+        } else if (sscanf (linha, "%lf,config,%d,%d", &s, &a, &b) == 3) {
+            c->cfgLiga = a;
+            c->cfgDesliga = b;
+            c->salvas = (c->salvas < 0) ? 1 : c->salvas + 1;
+            csv = true;
+        } else if (sscanf (linha, "%lf,agenda,%d,%d", &s, &a, &b) == 3) {
+            poeCapAgenda (c, (uint32_t) (s * 1000.0), a, b);
+            csv = true;
+        } else if (sscanf (linha, "%lf,rele,%d", &s, &a) == 2) {
+            trocasCSV++;
+            csv = true;
+        } else if (strchr (linha, ',') == NULL) {
+            ok = false;
+        }
+        // demais registros do CSV são ignorados
+    }
+    fclose (arq);
+    if (!ok) {
+        fprintf (stderr, "%s:%d: linha invalida\n", arquivo, nLinha);
+        return false;
+    }
+    if (c->nPontos == 0) {
+        fprintf (stderr, "%s: sem temperaturas\n", arquivo);
+        return false;
+    }
+
+    // A captura começa em um instante qualquer, reproduz a partir dele
+    uint32_t inicio = c->pontos[0].t;
+    if ((c->nTeclas > 0) && (c->teclas[0].t < inicio)) {
+        inicio = c->teclas[0].t;
+    }
+    for (int i = 0; i < c->nPontos; i++) {
+        c->pontos[i].t -= inicio;
+        c->duracao = c->pontos[i].t > c->duracao ? c->pontos[i].t : c->duracao;
+    }
+    for (int i = 0; i < c->nTeclas; i++) {
+        c->teclas[i].t -= inicio;
+        c->duracao = c->teclas[i].t > c->duracao ? c->teclas[i].t : c->duracao;
+    }
+    for (int i = 0; i < c->nHoras; i++) {
+        c->horas[i].t = (c->horas[i].t > inicio) ? c->horas[i].t - inicio : 0;
+    }
+    for (int i = 0; i < c->nCapAgenda; i++) {
+        c->capAgenda[i].t = (c->capAgenda[i].t > inicio) ? c->capAgenda[i].t - inicio : 0;
+    }
+    c->duracao += DT_LEITURA;
+    if (csv && (c->trocasMin < 0)) {
+        c->trocasMin = c->trocasMax = trocasCSV;
+    }
+    return true;
+}
+
+// Estado da trajetória durante a reprodução
+typedef struct {
+    uint32_t sem;
+    double passeio;
+    int iPonto;
+} TRAJ;
+
+// Temperatura no instante t (ms), em 1/16 grau
+static int32_t temperatura (const CENARIO *c, TRAJ *tr, uint32_t t) {
+    double temp;
+    double fase = fmod (t / 1000.0, c->periodo) / c->periodo;
+
+    switch (c->traj) {
+        case TR_RAMPA:
+            temp = c->tempBase + c->ampl * ((fase < 0.5) ? (4.0*fase - 1.0) : (3.0 - 4.0*fase));
+            break;
+        case TR_SENOIDE:
+            temp = c->tempBase + c->ampl * sin (2.0 * M_PI * fase);
+            break;
+        case TR_DEGRAU:
+            temp = c->tempBase + ((fase < 0.5) ? c->ampl : -c->ampl);
+            break;
+        case TR_PASSEIO:
+            // Passo limitado, puxado de volta para a base
+            tr->passeio += faixa (&tr->sem, -0.02, 0.02) - (tr->passeio / c->ampl) * 0.001;
+            temp = c->tempBase + tr->passeio;
+            break;
+        default:
+            // Gravada: interpola entre os pontos
+            while ((tr->iPonto < (c->nPontos - 1)) && (c->pontos[tr->iPonto+1].t <= t)) {
+                tr->iPonto++;
+            }
+            if ((tr->iPonto == (c->nPontos - 1)) || (c->pontos[tr->iPonto].t >= t)) {
+                temp = c->pontos[tr->iPonto].temp;
+            } else {
+                const PONTO *p0 = &c->pontos[tr->iPonto];
+                const PONTO *p1 = p0 + 1;
+                temp = p0->temp + (p1->temp - p0->temp) * (t - p0->t) / (double) (p1->t - p0->t);
+            }
+            return (int32_t) floor (temp * TEMP_ESCALA + 0.5);
+    }
+
+    // Ruído de quantização do sensor
+    int32_t leitura = (int32_t) floor (temp * TEMP_ESCALA + 0.5);
+    return leitura + (int32_t) (aleatorio(&tr->sem) % 3) - 1;
+}
+
+// Decisão esperada da histerese, independente de controle.cpp:
+// compara a temperatura arredondada para graus (como o roundf da versão
+// original) com os set points
+static bool oraculoHisterese (int32_t temp, int liga, int desliga, bool ligado) {
+    int graus = (int) round (temp / (double) TEMP_ESCALA);
+    if (graus < liga) {
+        return true;
+    }
+    if (graus > desliga) {
+        return false;
+    }
+    return ligado;
+}
+
+// Estado da configuração durante a reprodução
+typedef struct {
+    MENU menu;
+    TERMOSTATO *termo;              // set points alterados pelas teclas
+    int salvoLiga, salvoDesliga;    // "EEPROM"
+    int vigorLiga, vigorDesliga;    // salvos ou aplicados pela agenda
+    AGENDA agenda;                  // alterada pelas teclas
+    bool alterou;                   // houve alteração desde que entrou
+} UI;
+
+// Estado da agenda durante a reprodução
+typedef struct {
+    AGENDA agenda;      // salva (a que vale)
+    TABELA_AGENDA tab;
+    int minAcerto;      // minuto da semana acertado (-1 se não foi)
+    uint32_t tAcerto;   // instante do acerto (ms)
+    int minAnt;         // minuto da conferência anterior (-1 se nenhuma)
+    int entAnt, wAnt;   // transição em vigor na conferência anterior
+} RELOGIO;
+
+// Transição em vigor no minuto da semana indicado, independente de
+// agenda.cpp: a mais recente (circularmente) entre os dias e horários
+// de todas as entradas ativas; no mesmo horário vale a última entrada
+// Retorna o índice da entrada (-1 se nenhuma) e o minuto da transição
+static int emVigor (const AGENDA *ag, int min, int *w) {
+    int ent = -1, dist = MIN_SEMANA;
+    for (int i = 0; i < AGENDA_MAX; i++) {
+        const ENTRADA_AGENDA *e = &ag->ent[i];
+        if (e->dias == 0) {
+            continue;
+        }
+        for (int dia = 0; dia < 7; dia++) {
+            if (e->dias & (1 << dia)) {
+                int x = dia*MIN_DIA + e->minuto;
+                int d = (min - x + MIN_SEMANA) % MIN_SEMANA;
+                if (d <= dist) {
+                    ent = i;
+                    dist = d;
+                    *w = x;
+                }
+            }
+        }
+    }
+    return ent;
+}
+
+// Consulta a agenda como o core 1 e confere a transição em vigor
+// Retorna true se os set points foram alterados
+static bool passoAgenda (const CENARIO *c, RELOGIO *rel, uint32_t t, RESULTADO *res,
+                         int *liga, int *desliga) {
+    int min = -1;
+    if (rel->minAcerto >= 0) {
+        min = (int) ((rel->minAcerto + (t - rel->tAcerto) / 60000) % MIN_SEMANA);
+    }
+    bool agendou = agendaPasso (&rel->tab, min, liga, desliga);
+    if (min < 0) {
+        rel->minAnt = -1;
+    }
+    if ((min < 0) || (min == rel->minAnt)) {
+        if (agendou) {
+            falha (c, res, t, "agenda mudou sem mudar o minuto");
+        }
+        return agendou;
+    }
+
+    // O minuto mudou: confere com a procura nas entradas
+    char msg[80];
+    int w = -1;
+    int ent = emVigor (&rel->agenda, min, &w);
+    if (ent < 0) {
+        if (agendou) {
+            falha (c, res, t, "agenda vazia aplicou set points");
+        }
+    } else {
+        const TRANSICAO *tr = &rel->tab.trans[rel->tab.cursor];
+        const ENTRADA_AGENDA *e = &rel->agenda.ent[ent];
+        if ((tr->minSemana != w) || (tr->liga != e->liga) || (tr->desliga != e->desliga)) {
+            snprintf (msg, sizeof(msg), "agenda em %d/%d de %d, esperado %d/%d de %d (minuto %d)",
+                      tr->liga, tr->desliga, tr->minSemana, e->liga, e->desliga, w, min);
+            falha (c, res, t, msg);
+        }
+        bool esperado = (rel->minAnt >= 0) && ((ent != rel->entAnt) || (w != rel->wAnt) || (w == min));
+        if (agendou != esperado) {
+            snprintf (msg, sizeof(msg), "agenda %s no minuto %d (anterior %d)",
+                      agendou ? "aplicada" : "nao aplicada", min, rel->minAnt);
+            falha (c, res, t, msg);
+        }
+    }
+    rel->minAnt = min;
+    rel->entAnt = ent;
+    rel->wAnt = w;
+    return agendou;
+}
+
+static bool mesmaEntrada (const ENTRADA_AGENDA *a, const ENTRADA_AGENDA *b) {
+    return (a->dias == b->dias) && (a->minuto == b->minuto) &&
+           (a->liga == b->liga) && (a->desliga == b->desliga);
+}
+
+// Passa uma tecla pela edição da agenda e confere o resultado
+static void teclaAgenda (const CENARIO *c, UI *ui, RELOGIO *rel, int tecla, uint32_t t,
+                         RESULTADO *res) {
+    TERMOSTATO *termo = ui->termo;
+    int cpoAnt = ui->menu.cpo;
+    int entAnt = ui->menu.entrada;
+    int ligaAnt = termo->tempLiga;
+    int desligaAnt = termo->tempDesliga;
+    AGENDA ant = ui->agenda;
+
+    int acao = menuAgenda (&ui->menu, tecla, &ui->agenda);
+    res->teclas++;
+
+    if ((termo->tempLiga != ligaAnt) || (termo->tempDesliga != desligaAnt)) {
+        falha (c, res, t, "set points alterados na agenda");
+    }
+
+    // Só a entrada selecionada, um campo em um passo
+    bool alterada = false;
+    for (int i = 0; i < AGENDA_MAX; i++) {
+        const ENTRADA_AGENDA *e = &ui->agenda.ent[i];
+        const ENTRADA_AGENDA *a = &ant.ent[i];
+        if ((e->dias != 0) && !agendaValida (e)) {
+            falha (c, res, t, "entrada da agenda invalida");
+        }
+        if (mesmaEntrada (e, a)) {
+            continue;
+        }
+        alterada = true;
+        if (i != entAnt) {
+            falha (c, res, t, "alterou outra entrada da agenda");
+        }
+        int campos = (e->dias != a->dias) + (e->minuto != a->minuto) +
+                     (e->liga != a->liga) + (e->desliga != a->desliga);
+        int dMin = abs (e->minuto - a->minuto);
+        if ((campos != 1) || (abs (e->liga - a->liga) > 1) || (abs (e->desliga - a->desliga) > 1) ||
+            ((dMin > AG_PASSO_MIN) && (dMin < (MIN_DIA - AG_PASSO_MIN)))) {
+            falha (c, res, t, "tecla alterou mais de um passo da agenda");
+        }
+    }
+    if (alterada && ((cpoAnt == CPO_NENHUM) || (cpoAnt == CPO_AG_ENTRADA) || (tecla == TECLA_ENTER))) {
+        falha (c, res, t, "agenda alterada fora da edicao");
+    }
+
+    // Seleção das entradas
+    int entrada = ui->menu.entrada;
+    if ((entrada < 0) || (entrada > AGENDA_MAX)) {
+        falha (c, res, t, "selecao fora da agenda");
+    } else if ((cpoAnt == CPO_AG_ENTRADA) && (tecla != TECLA_ENTER)) {
+        int esperada = (entAnt + ((tecla == TECLA_UP) ? 1 : AGENDA_MAX)) % (AGENDA_MAX+1);
+        if (entrada != esperada) {
+            falha (c, res, t, "selecao da agenda nao andou uma entrada");
+        }
+    } else if ((cpoAnt == CPO_AG_DESLIGA) && (tecla == TECLA_ENTER) &&
+               ((ui->menu.cpo != CPO_AG_ENTRADA) || (entrada != (entAnt + 1) % (AGENDA_MAX+1)))) {
+        falha (c, res, t, "fim da entrada nao selecionou a seguinte");
+    }
+
+    if (cpoAnt == CPO_NENHUM) {
+        ui->alterou = false;
+    } else if (alterada) {
+        ui->alterou = true;
+    }
+    if ((cpoAnt != CPO_NENHUM) && !(acao & MENU_TELA)) {
+        falha (c, res, t, "tela nao atualizada na agenda");
+    }
+    if (acao & MENU_SALVA) {
+        if (ui->menu.cpo != CPO_NENHUM) {
+            falha (c, res, t, "agenda salva antes de sair");
+        }
+        if (!ui->alterou) {
+            falha (c, res, t, "agenda salva sem alteracao");
+        }
+
+        // Passa a valer; a próxima consulta só posiciona o cursor
+        rel->agenda = ui->agenda;
+        agendaCompila (&rel->agenda, &rel->tab);
+        rel->minAnt = -1;
+        res->salvasAgenda++;
+    }
+    if ((cpoAnt != CPO_NENHUM) && (ui->menu.cpo == CPO_NENHUM) && ui->alterou &&
+        !(acao & MENU_SALVA)) {
+        falha (c, res, t, "saiu da agenda alterada sem salvar");
+    }
+}
+
+// Passa uma tecla pela lógica de configuração e confere o resultado
+// Na página da agenda a tecla vai para a edição da agenda
+static void trataTecla (const CENARIO *c, UI *ui, RELOGIO *rel, int tecla, uint32_t t,
+                        RESULTADO *res) {
+    if (ui->menu.pagina == PAG_AGENDA) {
+        teclaAgenda (c, ui, rel, tecla, t, res);
+        return;
+    }
+    TERMOSTATO *termo = ui->termo;
+    int cpoAnt = ui->menu.cpo;
+    int ligaAnt = termo->tempLiga;
+    int desligaAnt = termo->tempDesliga;
+
+    int acao = menuTecla (&ui->menu, tecla, &termo->tempLiga, &termo->tempDesliga);
+    res->teclas++;
+
+    if ((termo->tempLiga < 0) || (termo->tempDesliga > 99) ||
+        (termo->tempLiga >= termo->tempDesliga)) {
+        falha (c, res, t, "set points fora da faixa");
+    }
+    int delta = abs (termo->tempLiga - ligaAnt) + abs (termo->tempDesliga - desligaAnt);
+    if (delta > 1) {
+        falha (c, res, t, "tecla alterou mais de um grau");
+    }
+    if ((delta != 0) && ((cpoAnt == CPO_NENHUM) || (tecla == TECLA_ENTER))) {
+        falha (c, res, t, "set point alterado fora da configuracao");
+    }
+    if (cpoAnt == CPO_NENHUM) {
+        ui->alterou = false;
+    } else if (delta != 0) {
+        ui->alterou = true;
+    }
+    if ((cpoAnt != CPO_NENHUM) && !(acao & MENU_TELA)) {
+        falha (c, res, t, "tela nao atualizada na configuracao");
+    }
+    if (acao & MENU_SALVA) {
+        if (ui->menu.cpo != CPO_NENHUM) {
+            falha (c, res, t, "configuracao salva antes de sair");
+        }
+        if (!ui->alterou) {
+            falha (c, res, t, "configuracao salva sem alteracao");
+        }
+        ui->salvoLiga = termo->tempLiga;
+        ui->salvoDesliga = termo->tempDesliga;
+        res->salvas++;
+    }
+    if ((cpoAnt != CPO_NENHUM) && (ui->menu.cpo == CPO_NENHUM) && ui->alterou &&
+        !(acao & MENU_SALVA)) {
+        falha (c, res, t, "saiu da configuracao alterada sem salvar");
+    }
+    if (acao & MENU_SALVA) {
+        ui->vigorLiga = termo->tempLiga;
+        ui->vigorDesliga = termo->tempDesliga;
+    }
+    if ((ui->menu.cpo == CPO_NENHUM) &&
+        ((termo->tempLiga != ui->vigorLiga) || (termo->tempDesliga != ui->vigorDesliga))) {
+        falha (c, res, t, "alteracao nao salva ao sair da configuracao");
+    }
+}
+
+// Reproduz um cenário
+static void reproduz (const CENARIO *c, RESULTADO *res) {
+    TERMOSTATO termo;
+    UI ui;
+    RELOGIO rel;
+    TRAJ tr;
+    char msg[80];
+
+    memset (res, 0, sizeof(RESULTADO));
+    termostatoInit (&termo, c->modo, c->liga, c->desliga);
+    menuInit (&ui.menu);
+    ui.termo = &termo;
+    ui.salvoLiga = c->liga;
+    ui.salvoDesliga = c->desliga;
+    ui.vigorLiga = c->liga;
+    ui.vigorDesliga = c->desliga;
+    ui.alterou = false;
+    ui.agenda = c->agenda;
+    rel.agenda = c->agenda;
+    agendaCompila (&rel.agenda, &rel.tab);
+    rel.minAcerto = -1;
+    rel.tAcerto = 0;
+    rel.minAnt = -1;
+    rel.entAnt = rel.wAnt = -1;
+    tr.sem = c->semente ^ 0x5A5A5A5A;
+    tr.passeio = 0.0;
+    tr.iPonto = 0;
+
+    bool rele = false;
+    bool houveTroca = false;
+    uint32_t ultimaTroca = 0;
+    uint32_t inicioErro = 0;        // relê contrário a um erro grande desde (PID)
+    int iTecla = 0;
+    int iHora = 0;
+    int iCap = 0;
+
+    for (uint32_t t = 0; t < c->duracao; t += DT_LEITURA) {
+        uint32_t agora = c->base + t;
+
+        // Teclas até esta leitura (laço do core 0)
+        while ((iTecla < c->nTeclas) && (c->teclas[iTecla].t <= t)) {
+            trataTecla (c, &ui, &rel, c->teclas[iTecla].tecla, c->teclas[iTecla].t, res);
+            iTecla++;
+        }
+
+        // Acertos do relógio até esta leitura
+        while ((iHora < c->nHoras) && (c->horas[iHora].t <= t)) {
+            rel.minAcerto = c->horas[iHora].minSemana;
+            rel.tAcerto = t;
+            iHora++;
+        }
+
+        // Agenda e passo do controle (core 1)
+        int liga, desliga;
+        bool agendou = passoAgenda (c, &rel, t, res, &liga, &desliga);
+        while ((iCap < c->nCapAgenda) && (c->capAgenda[iCap].t <= t)) {
+            liga = c->capAgenda[iCap].liga;
+            desliga = c->capAgenda[iCap].desliga;
+            agendou = true;
+            iCap++;
+        }
+        if (agendou) {
+            termo.tempLiga = liga;
+            termo.tempDesliga = desliga;
+            ui.vigorLiga = liga;
+            ui.vigorDesliga = desliga;
+            res->agendadas++;
+        }
+        int32_t temp = temperatura (c, &tr, t);
+        termostatoPasso (&termo, temp, agora);
+        bool novo = termo.ligado;
+        res->leituras++;
+
+        if (c->modo == CTL_HISTERESE) {
+            if (novo != oraculoHisterese (temp, termo.tempLiga, termo.tempDesliga, rele)) {
+                snprintf (msg, sizeof(msg), "rele %s com %.4f graus (liga %d desliga %d)",
+                          novo ? "ligado" : "desligado", temp / (double) TEMP_ESCALA,
+                          termo.tempLiga, termo.tempDesliga);
+                falha (c, res, t, msg);
+            }
+        } else {
+            uint32_t minimo = rele ? termo.controle.par.minLigado : termo.controle.par.minDesligado;
+            bool podeTrocar = !houveTroca || ((agora - ultimaTroca) >= minimo);
+            if ((novo != rele) && !podeTrocar) {
+                snprintf (msg, sizeof(msg), "rele %s por apenas %.1f s",
+                          rele ? "ligado" : "desligado", (agora - ultimaTroca) / 1000.0);
+                falha (c, res, t, msg);
+            }
+            if (c->modo == CTL_ANTECIPA) {
+                // A antecipação só pode adiantar a troca em relação à
+                // histerese e, sem antecipação aprendida no sentido da
+                // troca, tem que decidir igual a ela
+                bool histerese = oraculoHisterese (temp, termo.tempLiga, termo.tempDesliga, rele);
+                const ANTECIPA *ant = &termo.controle.ant;
+                uint32_t ta = rele ? ant->taDesliga : ant->taLiga;
+                if (podeTrocar && (novo == rele) && (histerese != rele)) {
+                    snprintf (msg, sizeof(msg), "rele ainda %s com %.4f graus (liga %d desliga %d)",
+                              novo ? "ligado" : "desligado", temp / (double) TEMP_ESCALA,
+                              termo.tempLiga, termo.tempDesliga);
+                    falha (c, res, t, msg);
+                } else if (podeTrocar && (ta == 0) && (novo != histerese)) {
+                    snprintf (msg, sizeof(msg), "rele %s sem antecipacao com %.4f graus (liga %d desliga %d)",
+                              novo ? "ligado" : "desligado", temp / (double) TEMP_ESCALA,
+                              termo.tempLiga, termo.tempDesliga);
+                    falha (c, res, t, msg);
+                }
+            } else {
+                // Com um erro grande o relê tem que reagir em até duas janelas
+                // (um salto na leitura no início da janela pode anular a saída
+                // desta janela pelo termo derivativo)
+                int32_t erro = (termo.controle.tempLiga + termo.controle.tempDesliga) / 2 - temp;
+                int sinal = (erro >= ERRO_GRANDE) ? 1 : (erro <= -ERRO_GRANDE) ? -1 : 0;
+                if ((sinal == 0) || (novo == (sinal > 0))) {
+                    inicioErro = t;
+                } else if ((t - inicioErro) > (2*termo.controle.par.janela + DT_LEITURA)) {
+                    snprintf (msg, sizeof(msg), "rele %s com erro de %.2f graus por %.0f s",
+                              novo ? "ligado" : "desligado", erro / (double) TEMP_ESCALA,
+                              (t - inicioErro) / 1000.0);
+                    falha (c, res, t, msg);
+                    inicioErro = t;
+                }
+            }
+        }
+        if (novo != rele) {
+            res->trocas++;
+            houveTroca = true;
+            ultimaTroca = agora;
+            rele = novo;
+        }
+    }
+
+    // Expectativas do cenário
+    if ((c->trocasMin >= 0) && ((res->trocas < c->trocasMin) || (res->trocas > c->trocasMax))) {
+        snprintf (msg, sizeof(msg), "%d trocas do rele, esperadas %d a %d",
+                  res->trocas, c->trocasMin, c->trocasMax);
+        falha (c, res, c->duracao, msg);
+    }
+    if ((c->cfgLiga >= 0) && ((ui.salvoLiga != c->cfgLiga) || (ui.salvoDesliga != c->cfgDesliga))) {
+        snprintf (msg, sizeof(msg), "configuracao salva %d/%d, esperada %d/%d",
+                  ui.salvoLiga, ui.salvoDesliga, c->cfgLiga, c->cfgDesliga);
+        falha (c, res, c->duracao, msg);
+    }
+    if ((c->salvas >= 0) && (res->salvas != c->salvas)) {
+        snprintf (msg, sizeof(msg), "%d salvamentos, esperados %d", res->salvas, c->salvas);
+        falha (c, res, c->duracao, msg);
+    }
+    if ((c->salvasAgenda >= 0) && (res->salvasAgenda != c->salvasAgenda)) {
+        snprintf (msg, sizeof(msg), "%d salvamentos da agenda, esperados %d",
+                  res->salvasAgenda, c->salvasAgenda);
+        falha (c, res, c->duracao, msg);
+    }
+    if ((c->spLiga >= 0) && ((termo.tempLiga != c->spLiga) || (termo.tempDesliga != c->spDesliga))) {
+        snprintf (msg, sizeof(msg), "set points %d/%d, esperados %d/%d",
+                  termo.tempLiga, termo.tempDesliga, c->spLiga, c->spDesliga);
+        falha (c, res, c->duracao, msg);
+    }
+    if (verboso) {
+        printf ("%s: %s %s, %.1f h, %d trocas, %d teclas, %d salvas, %d agendadas, %d agenda, %d falhas\n",
+                c->nome, nomeModo (c->modo),
+                (c->traj >= 0) ? nomeTraj[c->traj] : "gravada",
+                c->duracao / 3600000.0, res->trocas, res->teclas, res->salvas, res->agendadas,
+                res->salvasAgenda, res->falhas);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long nCenarios = -1;
+    double horas = HORAS_PADRAO;
+    uint32_t semente = 1;
+    int nArquivos = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc)) {
+            nCenarios = atol (argv[++i]);
+        } else if ((strcmp (argv[i], "-h") == 0) && (i+1 < argc)) {
+            horas = atof (argv[++i]);
+        } else if ((strcmp (argv[i], "-s") == 0) && (i+1 < argc)) {
+            semente = (uint32_t) atol (argv[++i]);
+        } else if (strcmp (argv[i], "-v") == 0) {
+            verboso = true;
+        } else if (argv[i][0] == '-') {
+            fprintf (stderr, "uso: replay [-n cenarios] [-h horas] [-s semente] [-v] [arquivo ...]\n");
+            return 1;
+        } else {
+            nArquivos++;
+        }
+    }
+    if (nCenarios < 0) {
+        nCenarios = (nArquivos > 0) ? 0 : N_PADRAO;
+    }
+
+    long total = 0, comFalha = 0, leituras = 0;
+    double horasSimuladas = 0.0;
+    struct timespec t0, t1;
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+
+    // Cenários dos arquivos
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp (argv[i], "-n") == 0) || (strcmp (argv[i], "-h") == 0) ||
+            (strcmp (argv[i], "-s") == 0)) {
+            i++;
+            continue;
+        }
+        if (argv[i][0] == '-') {
+            continue;
+        }
+        CENARIO c;
+        RESULTADO res;
+        total++;
+        if (!leCenario (&c, argv[i])) {
+            comFalha++;
+            liberaCenario (&c);
+            continue;
+        }
+        reproduz (&c, &res);
+        if (res.falhas) {
+            comFalha++;
+        }
+        leituras += res.leituras;
+        horasSimuladas += c.duracao / 3600000.0;
+        liberaCenario (&c);
+    }
+
+    // Cenários sintéticos
+    for (long k = 0; k < nCenarios; k++) {
+        CENARIO c;
+        RESULTADO res;
+        geraCenario (&c, semente + (uint32_t) k, horas);
+        reproduz (&c, &res);
+        total++;
+        if (res.falhas) {
+            comFalha++;
+        }
+        leituras += res.leituras;
+        horasSimuladas += c.duracao / 3600000.0;
+        liberaCenario (&c);
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    double seg = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf ("Cenarios: %ld, com falha: %ld\n", total, comFalha);
+    printf ("Simulado: %.0f h (%ld leituras) em %.2f s\n", horasSimuladas, leituras, seg);
+    if (seg > 0) {
+        printf ("Vazao: %.0f horas simuladas/s, %.0f ns por leitura\n",
+                horasSimuladas / seg, 1e9 * seg / leituras);
+    }
+    return (comFalha == 0) ? 0 : 1;
+}
@@ -0,0 +1,416 @@
+/**
+ * @file simula.cpp
+ * @author Daniel Quadros
+ * @brief Simulação do controle do termostato contra o modelo térmico
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Uso: simula [histerese|pid|autotune|antecipa] [horas] [liga] [desliga] [script]
+ *
+ * Roda a mesma lógica de controle do firmware (controle.cpp) com
+ * leituras a cada 750 ms (tempo de conversão do DS18B20) e apresenta
+ * um resumo do comportamento.
+ *
+ * O script opcional contém comandos para o interpretador da serial
+ * (comandos.cpp), um por linha, precedidos do instante em horas:
+ *   0.5 get
+ *   2 set desliga 24
+ *   2 salva
+ * As respostas são apresentadas precedidas do instante.
+ *
+ * O relógio da simulação começa parado; acertado pelo comando "hora"
+ * ele passa a avançar com o tempo simulado e a agenda (agenda.cpp),
+ * editada pelo comando "agenda", muda os set points como no firmware:
+ *   0 hora seg 06:00
+ *   0 agenda 0 xxxxxxx 07:00 21 23
+ *   0 agenda 1 xxxxxxx 22:00 17 19
+ *
+ * O relê e a EEPROM são os periféricos simulados da placa PlacaHost
+ * (perifericos_host.h), com a mesma interface dos drivers do firmware.
+ * A configuração é salva na EEPROM pelo mesmo gerenciador do firmware
+ * (config.cpp). O uso do relê é contabilizado pelo mesmo módulo do
+ * firmware (uso.cpp) e conferido com o tempo ligado medido na simulação.
+ *
+ * Os tempos aprendidos pela antecipação são gravados na configuração
+ * como no firmware e, no final, é conferido que uma nova partida os
+ * carrega; o resumo mostra o quanto a temperatura passou dos set
+ * points, que é o que a antecipação deve reduzir.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "termostato.h"
+#include "comandos.h"
+#include "planta.h"
+#include "config.h"
+#include "uso.h"
+#include "agenda.h"
+#include "perifericos_host.h"
+
+#define DT_PLANTA   0.25    // passo da simulação do modelo (s)
+#define PASSOS_LEITURA 3    // uma leitura a cada 3 passos (750 ms)
+#define CFG_ADDR 64         // posição da configuração na EEPROM, como no firmware
+#define USO_ADDR 192        // posição dos totais do uso do relê, como no firmware
+#define AGENDA_ADDR 256     // posição da agenda, como no firmware
+
+// Estatísticas da simulação
+typedef struct {
+    double maxAcima;        // maior temperatura acima do set point
+    double maxAbaixo;       // maior temperatura abaixo do set point
+    double alemDesliga;     // maior temperatura acima de "desliga"
+    double alemLiga;        // maior temperatura abaixo de "liga"
+    double somaErro;        // soma do erro absoluto (regime)
+    long nErro;
+    double tempoLigado;     // s
+    double nsPasso;         // tempo médio do passo de controle no host
+} ESTAT;
+
+// Estado da simulação (acessado também pelos comandos)
+static PLANTA planta;
+static TERMOSTATO termo;
+static int32_t tempAtual = 0;   // 1/16 grau
+static uint32_t agora;          // ms
+static ESTAT est;
+static long nControle = 0;
+static GERCONFIG gerConfig;
+static USO uso;
+static uint32_t seqUso;
+static AGENDA agenda;
+static TABELA_AGENDA tabAgenda;
+static uint32_t seqAgenda;
+static long nAgenda = 0;        // transições da agenda aplicadas
+
+// Relógio simulado: minuto da semana no acerto (-1 se não acertado)
+static int minAcerto = -1;
+static uint32_t msAcerto;
+
+static int minutoSemana () {
+    if (minAcerto < 0) {
+        return -1;
+    }
+    return (int) ((minAcerto + (agora - msAcerto) / 60000) % MIN_SEMANA);
+}
+
+// Funções usadas pelo interpretador de comandos
+
+void appLeSetPoints (int *pLiga, int *pDesliga) {
+    *pLiga = termo.tempLiga;
+    *pDesliga = termo.tempDesliga;
+}
+
+void appMudaSetPoints (int novoLiga, int novoDesliga) {
+    termo.tempLiga = novoLiga;
+    termo.tempDesliga = novoDesliga;
+}
+
+// Registra os tempos aprendidos pela antecipação, como no firmware
+#define ANT_TOLERANCIA  5
+static void salvaAntecipacao () {
+    if (termo.controle.modo != CTL_ANTECIPA) {
+        return;
+    }
+    CONFIG cfg = gerConfig.atual;
+    uint16_t aLiga = (uint16_t) (termo.controle.ant.taLiga / 1000);
+    uint16_t aDesliga = (uint16_t) (termo.controle.ant.taDesliga / 1000);
+    if ((abs(aLiga - cfg.antLiga) > ANT_TOLERANCIA) ||
+        (abs(aDesliga - cfg.antDesliga) > ANT_TOLERANCIA)) {
+        cfg.antLiga = aLiga;
+        cfg.antDesliga = aDesliga;
+        configMuda (&gerConfig, &cfg, agora);
+    }
+}
+
+void appSalvaConfig () {
+    CONFIG cfg = gerConfig.atual;
+    cfg.tempLiga = termo.tempLiga;
+    cfg.tempDesliga = termo.tempDesliga;
+    configMuda (&gerConfig, &cfg, agora);
+    configGrava (&gerConfig);
+}
+
+int32_t appTemperatura () {
+    return tempAtual;
+}
+
+bool appRele () {
+    return RELE::ligado();
+}
+
+int appModo () {
+    return termo.controle.modo;
+}
+
+void appPedeModo (int modo) {
+    termostatoPedeModo (&termo, modo);
+}
+
+int appSensores (int32_t *temps, int max) {
+    if (max < 1) {
+        return 0;
+    }
+    temps[0] = plantaSensor (&planta);
+    return 1;
+}
+
+void appEstatisticas (CMD_ESTAT *estat) {
+    estat->tempo = agora;
+    estat->passos = nControle;
+    estat->trocas = termo.nTrocas;
+    estat->maxPasso = 0;
+    estat->primeiraDecisao = 0;
+    estat->saida = termo.controle.saida;
+    estat->par = termo.controle.par;
+    estat->antLiga = termo.controle.ant.taLiga;
+    estat->antDesliga = termo.controle.ant.taDesliga;
+    estat->nMedidas = termo.controle.ant.nMedidas;
+}
+
+// No PC não há o que medir
+void appEnergia (CMD_ENERGIA *e) {
+    memset (e, 0, sizeof(CMD_ENERGIA));
+}
+
+void appUso (USO_RESUMO *res) {
+    usoResumo (&uso, agora, res);
+}
+
+bool appLeHora (int *dia, int *minuto) {
+    int min = minutoSemana ();
+    if (min < 0) {
+        return false;
+    }
+    *dia = min / MIN_DIA;
+    *minuto = min % MIN_DIA;
+    return true;
+}
+
+void appAcertaHora (int dia, int minuto) {
+    minAcerto = dia*MIN_DIA + minuto;
+    msAcerto = agora;
+}
+
+void appLeAgenda (AGENDA *ag) {
+    *ag = agenda;
+}
+
+void appMudaAgenda (const AGENDA *ag) {
+    agenda = *ag;
+    agendaCompila (&agenda, &tabAgenda);
+    agendaGrava (&agenda, AGENDA_ADDR, &seqAgenda);
+}
+
+bool appEepromLe (uint8_t *buffer, uint32_t addr, int n) {
+    return EEPROM::read (buffer, addr, n);
+}
+
+bool appEepromGrava (const uint8_t *buffer, uint32_t addr, int n) {
+    return EEPROM::write (buffer, addr, n);
+}
+
+void appEscreve (const char *txt) {
+    printf ("[%7.3f h] %s\n", agora / 3600000.0, txt);
+}
+
+// Próximo comando do script
+typedef struct {
+    FILE *arq;
+    double horas;       // instante do comando (negativo se acabou)
+    char linha[CMD_TAM_LINHA+16];
+} SCRIPT;
+
+static void proxComando (SCRIPT *scr) {
+    scr->horas = -1.0;
+    while ((scr->arq != NULL) && (fgets(scr->linha, sizeof(scr->linha), scr->arq) != NULL)) {
+        int pos;
+        if ((scr->linha[0] != '#') && (sscanf(scr->linha, "%lf %n", &scr->horas, &pos) == 1)) {
+            memmove (scr->linha, scr->linha + pos, strlen(scr->linha + pos) + 1);
+            return;
+        }
+        scr->horas = -1.0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int modo = CTL_HISTERESE;
+    double horas = 12.0;
+    int liga = 20;
+    int desliga = 22;
+    SCRIPT scr;
+    scr.arq = NULL;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "pid") == 0) {
+            modo = CTL_PID;
+        } else if (strcmp(argv[1], "autotune") == 0) {
+            modo = CTL_AUTOTUNE;
+        } else if (strcmp(argv[1], "antecipa") == 0) {
+            modo = CTL_ANTECIPA;
+        } else if (strcmp(argv[1], "histerese") != 0) {
+            fprintf (stderr, "uso: simula [histerese|pid|autotune|antecipa] [horas] [liga] [desliga] [script]\n");
+            return 1;
+        }
+    }
+    if (argc > 2) {
+        horas = atof(argv[2]);
+    }
+    if (argc > 3) {
+        liga = atoi(argv[3]);
+    }
+    if (argc > 4) {
+        desliga = atoi(argv[4]);
+    }
+    if (argc > 5) {
+        scr.arq = fopen(argv[5], "r");
+        if (scr.arq == NULL) {
+            perror (argv[5]);
+            return 1;
+        }
+    }
+
+    PLANTA_PARAM par;
+    plantaParamPadrao (&par);
+    plantaInit (&planta, &par, 15.0, DT_PLANTA);
+
+    termostatoInit (&termo, modo, liga, desliga);
+    RELE::init (termo.ligado);
+    EEPROM::init ();
+    configInit (&gerConfig, CFG_ADDR, EEPROM::pagina());
+    appSalvaConfig ();
+    USO_TOTAL totalUso;
+    usoCarrega (&totalUso, USO_ADDR, &seqUso);
+    usoInit (&uso, &totalUso, termo.ligado, 0);
+    agendaCarrega (&agenda, AGENDA_ADDR, &seqAgenda);
+    agendaCompila (&agenda, &tabAgenda);
+
+    INTERPRETADOR interp;
+    cmdInit (&interp);
+    proxComando (&scr);
+
+    memset (&est, 0, sizeof(est));
+    long nPassos = (long) (horas * 3600.0 / DT_PLANTA);
+    long inicioRegime = nPassos / 2;
+    bool sintonizando = (modo == CTL_AUTOTUNE);
+    double tempoPassos = 0.0;
+
+    for (long i = 0; i < nPassos; i++) {
+        agora = (uint32_t) (i * DT_PLANTA * 1000.0);
+
+        // Comandos do script
+        while ((scr.horas >= 0) && ((scr.horas * 3600000.0) <= agora)) {
+            for (char *p = scr.linha; *p; p++) {
+                cmdRecebe (&interp, *p);
+            }
+            proxComando (&scr);
+        }
+
+        if ((i % PASSOS_LEITURA) == 0) {
+            int32_t leitura = plantaSensor (&planta);
+            tempAtual = leitura;
+
+            if (termo.pedidoModo >= 0) {
+                sintonizando = (termo.pedidoModo == CTL_AUTOTUNE);
+            }
+
+            struct timespec t0, t1;
+            clock_gettime (CLOCK_MONOTONIC, &t0);
+            int sLiga, sDesliga;
+            if (agendaPasso (&tabAgenda, minutoSemana(), &sLiga, &sDesliga)) {
+                termo.tempLiga = sLiga;
+                termo.tempDesliga = sDesliga;
+                nAgenda++;
+            }
+            if (termostatoPasso (&termo, leitura, agora)) {
+                RELE::aciona (termo.ligado);
+                usoTroca (&uso, termo.ligado, agora);
+            } else {
+                usoPoll (&uso, agora);
+            }
+            clock_gettime (CLOCK_MONOTONIC, &t1);
+            salvaAntecipacao ();
+            configPoll (&gerConfig, agora);
+            if (uso.gravar) {
+                USO_TOTAL total;
+                usoTotal (&uso, agora, &total);
+                usoGrava (&total, USO_ADDR, &seqUso);
+                uso.gravar = false;
+            }
+            tempoPassos += (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+            nControle++;
+
+            if (sintonizando && (termo.controle.modo != CTL_AUTOTUNE)) {
+                sintonizando = false;
+                printf ("Auto-sintonia %s em %.2f h: kp=%d ki=%d kd=%d\n",
+                        termo.controle.at.concluida ? "concluida" : "falhou",
+                        i * DT_PLANTA / 3600.0, termo.controle.par.kp, termo.controle.par.ki,
+                        termo.controle.par.kd);
+                inicioRegime = i + (nPassos - i) / 2;
+            }
+        }
+        plantaPasso (&planta, RELE::ligado(), DT_PLANTA);
+        if (RELE::ligado()) {
+            est.tempoLigado += DT_PLANTA;
+        }
+        if (i >= inicioRegime) {
+            double erro = planta.tempAmbiente - (termo.tempLiga + termo.tempDesliga) / 2.0;
+            if (erro > est.maxAcima) {
+                est.maxAcima = erro;
+            }
+            if (-erro > est.maxAbaixo) {
+                est.maxAbaixo = -erro;
+            }
+            est.somaErro += (erro < 0) ? -erro : erro;
+            if ((planta.tempAmbiente - termo.tempDesliga) > est.alemDesliga) {
+                est.alemDesliga = planta.tempAmbiente - termo.tempDesliga;
+            }
+            if ((termo.tempLiga - planta.tempAmbiente) > est.alemLiga) {
+                est.alemLiga = termo.tempLiga - planta.tempAmbiente;
+            }
+            est.nErro++;
+        }
+    }
+    est.nsPasso = tempoPassos / nControle;
+
+    printf ("Modo final: %s\n", (termo.controle.modo == CTL_PID) ? "PID" :
+                                (termo.controle.modo == CTL_AUTOTUNE) ? "auto-sintonia" :
+                                (termo.controle.modo == CTL_ANTECIPA) ? "antecipacao" : "histerese");
+    printf ("Set points: liga %d desliga %d (alvo %.1f)\n", termo.tempLiga, termo.tempDesliga,
+            (termo.tempLiga + termo.tempDesliga) / 2.0);
+    if (nAgenda > 0) {
+        printf ("Agenda: %ld transicoes aplicadas\n", nAgenda);
+    }
+    GERCONFIG salva;
+    configInit (&salva, CFG_ADDR, EEPROM::pagina());
+    printf ("Configuracao salva: liga %d desliga %d\n", salva.atual.tempLiga, salva.atual.tempDesliga);
+    printf ("Antecipacao: liga %lu s desliga %lu s, %lu medidas (gravado %d s / %d s)\n",
+            (unsigned long) (termo.controle.ant.taLiga / 1000), (unsigned long) (termo.controle.ant.taDesliga / 1000),
+            (unsigned long) termo.controle.ant.nMedidas,
+            salva.atual.antLiga, salva.atual.antDesliga);
+    printf ("Trocas do rele: %ld em %.1f h\n", RELE::nTrocas, horas);
+    printf ("Ciclo de trabalho: %.1f%%\n", 100.0 * est.tempoLigado / (horas * 3600.0));
+    USO_RESUMO res;
+    usoResumo (&uso, agora, &res);
+    USO_TOTAL gravado;
+    uint32_t seqGravado;
+    usoCarrega (&gravado, USO_ADDR, &seqGravado);
+    printf ("Uso do rele: ligado %lu s de %lu s, %lu ciclos (%lu curtos), gravado %lu s em %lu copias\n",
+            (unsigned long) res.total.segLigado, (unsigned long) res.total.segContado,
+            (unsigned long) res.total.ciclos, (unsigned long) res.total.curtos,
+            (unsigned long) gravado.segLigado, (unsigned long) seqGravado);
+    printf ("Uso do rele: ciclo de trabalho %u.%u%% nas ultimas %d h, %u.%u%% na hora atual%s\n",
+            res.ciclo24h / 10, res.ciclo24h % 10, res.nHoras, res.cicloHora / 10, res.cicloHora % 10,
+            res.alerta ? ", ALERTA de ciclos curtos" : "");
+    printf ("Em regime: max acima %.2f, max abaixo %.2f, erro medio %.3f graus\n",
+            est.maxAcima, est.maxAbaixo, est.nErro ? est.somaErro / est.nErro : 0.0);
+    printf ("Em regime: max %.2f acima de desliga, %.2f abaixo de liga\n", est.alemDesliga, est.alemLiga);
+    printf ("Tempo medio do passo de controle (host): %.0f ns\n", est.nsPasso);
+    if (scr.arq != NULL) {
+        fclose (scr.arq);
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file teldec.cpp
+ * @author Daniel Quadros
+ * @brief Decodificador da telemetria do termostato
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Uso: teldec [-r] [arquivo]
+ *
+ * Lê a telemetria capturada (ou a entrada padrão, por exemplo a
+ * serial já configurada com stty) e gera uma linha CSV por registro:
+ *   tempo (s), tipo, valores
+ * Com -r apresenta somente um resumo no final.
+ *
+ * O instante nos registros é de 32 bits em us e dá a volta a cada
+ * 71 minutos; a volta é detectada para capturas longas.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "controle.h"
+#include "telemetria.h"
+
+// Resumo da captura
+typedef struct {
+    long registros[TEL_AGENDA+1];
+    long invalidos;
+    long perdidos;
+    double tempMin, tempMax, somaTemp;
+    long nTemp;
+    long trocas;
+    double tLigou;          // instante em que o relê ligou (-1 se desligado)
+    double tempoLigado;
+    double inicio, fim;
+    uint32_t leituraMin, leituraMax, controleMin, controleMax;
+    double somaLeitura, somaControle;
+    long nPasso;
+} RESUMO;
+
+static inline int16_t le16(const uint8_t *p) {
+    return (int16_t) (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t le32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// Tamanho dos dados de cada tipo
+static int tamDados(uint8_t tipo) {
+    switch (tipo) {
+        case TEL_TEMP:   return 5;
+        case TEL_SENSOR: return 3;
+        case TEL_RELE:   return 1;
+        case TEL_PASSO:  return 8;
+        case TEL_TECLA:  return 1;
+        case TEL_CONFIG: return 2;
+        case TEL_PERDA:  return 2;
+        case TEL_AGENDA: return 2;
+    }
+    return -1;
+}
+
+// Trata um registro decodificado
+static void trataRegistro(const uint8_t *reg, int tam, double tempo, bool csv, RESUMO *res) {
+    uint8_t tipo = reg[0];
+    const uint8_t *d = &reg[5];
+
+    if (tamDados(tipo) != (tam - 6)) {
+        res->invalidos++;
+        return;
+    }
+    res->registros[tipo]++;
+    if (res->inicio < 0) {
+        res->inicio = tempo;
+    }
+    res->fim = tempo;
+
+    switch (tipo) {
+        case TEL_TEMP: {
+            double temp = le16(d) / (double) TEMP_ESCALA;
+            if (csv) {
+                printf ("%.6f,temp,%.4f,%u,%u\n", tempo, temp, (uint16_t) le16(d+2), d[4]);
+            }
+            if ((res->nTemp == 0) || (temp < res->tempMin)) {
+                res->tempMin = temp;
+            }
+            if ((res->nTemp == 0) || (temp > res->tempMax)) {
+                res->tempMax = temp;
+            }
+            res->somaTemp += temp;
+            res->nTemp++;
+            break;
+        }
+        case TEL_SENSOR:
+            if (csv) {
+                printf ("%.6f,sensor,%u,%.4f\n", tempo, d[0], le16(d+1) / (double) TEMP_ESCALA);
+            }
+            break;
+        case TEL_RELE:
+            if (csv) {
+                printf ("%.6f,rele,%u\n", tempo, d[0]);
+            }
+            res->trocas++;
+            if (d[0] && (res->tLigou < 0)) {
+                res->tLigou = tempo;
+            } else if (!d[0] && (res->tLigou >= 0)) {
+                res->tempoLigado += tempo - res->tLigou;
+                res->tLigou = -1;
+            }
+            break;
+        case TEL_PASSO: {
+            uint32_t leitura = le32(d);
+            uint32_t controle = le32(d+4);
+            if (csv) {
+                printf ("%.6f,passo,%u,%u\n", tempo, leitura, controle);
+            }
+            if ((res->nPasso == 0) || (leitura < res->leituraMin)) {
+                res->leituraMin = leitura;
+            }
+            if (leitura > res->leituraMax) {
+                res->leituraMax = leitura;
+            }
+            if ((res->nPasso == 0) || (controle < res->controleMin)) {
+                res->controleMin = controle;
+            }
+            if (controle > res->controleMax) {
+                res->controleMax = controle;
+            }
+            res->somaLeitura += leitura;
+            res->somaControle += controle;
+            res->nPasso++;
+            break;
+        }
+        case TEL_TECLA:
+            if (csv) {
+                printf ("%.6f,tecla,%u\n", tempo, d[0]);
+            }
+            break;
+        case TEL_CONFIG:
+            if (csv) {
+                printf ("%.6f,config,%d,%d\n", tempo, (int8_t) d[0], (int8_t) d[1]);
+            }
+            break;
+        case TEL_PERDA:
+            if (csv) {
+                printf ("%.6f,perda,%u\n", tempo, (uint16_t) le16(d));
+            }
+            res->perdidos += (uint16_t) le16(d);
+            break;
+        case TEL_AGENDA:
+            if (csv) {
+                printf ("%.6f,agenda,%d,%d\n", tempo, (int8_t) d[0], (int8_t) d[1]);
+            }
+            break;
+    }
+}
+
+// Apresenta o resumo
+static void mostraResumo(RESUMO *res) {
+    long total = 0;
+    for (int i = 0; i <= TEL_AGENDA; i++) {
+        total += res->registros[i];
+    }
+    double duracao = (res->inicio < 0) ? 0.0 : res->fim - res->inicio;
+    if (res->tLigou >= 0) {
+        res->tempoLigado += res->fim - res->tLigou;
+    }
+    fprintf (stderr, "Registros: %ld validos, %ld invalidos, %ld perdidos no envio\n",
+             total, res->invalidos, res->perdidos);
+    fprintf (stderr, "Duracao: %.1f s\n", duracao);
+    if (res->nTemp > 0) {
+        fprintf (stderr, "Temperatura: min %.2f max %.2f media %.2f (%ld leituras)\n",
+                 res->tempMin, res->tempMax, res->somaTemp / res->nTemp, res->nTemp);
+    }
+    fprintf (stderr, "Rele: %ld trocas, ligado %.1f%% do tempo\n", res->trocas,
+             (duracao > 0) ? 100.0 * res->tempoLigado / duracao : 0.0);
+    if (res->nPasso > 0) {
+        fprintf (stderr, "Leitura (us): min %u media %.0f max %u\n", res->leituraMin,
+                 res->somaLeitura / res->nPasso, res->leituraMax);
+        fprintf (stderr, "Controle (us): min %u media %.0f max %u\n", res->controleMin,
+                 res->somaControle / res->nPasso, res->controleMax);
+    }
+    fprintf (stderr, "Teclas: %ld, configuracoes salvas: %ld, transicoes da agenda: %ld\n",
+             res->registros[TEL_TECLA], res->registros[TEL_CONFIG], res->registros[TEL_AGENDA]);
+}
+
+int main(int argc, char *argv[]) {
+    bool csv = true;
+    FILE *arq = stdin;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0) {
+            csv = false;
+        } else {
+            arq = fopen(argv[i], "rb");
+            if (arq == NULL) {
+                perror (argv[i]);
+                return 1;
+            }
+        }
+    }
+
+    RESUMO res;
+    memset (&res, 0, sizeof(res));
+    res.inicio = -1;
+    res.tLigou = -1;
+
+    uint8_t quadro[TEL_MAX_QUADRO];
+    uint8_t reg[TEL_MAX_QUADRO];
+    int n = 0;
+    bool descarta = true;       // até o primeiro terminador o quadro pode estar incompleto
+    int64_t ultimo = -1;        // último instante, já sem as voltas (us)
+    int c;
+
+    while ((c = fgetc(arq)) != EOF) {
+        if (c != 0) {
+            if (n < (int) sizeof(quadro)) {
+                quadro[n] = (uint8_t) c;
+            }
+            n++;
+            continue;
+        }
+        if (descarta) {
+            descarta = false;
+        } else if (n > 0) {
+            int tam = (n <= (int) sizeof(quadro)) ? telDecodifica(reg, quadro, n) : -1;
+            if (tam < 0) {
+                res.invalidos++;
+            } else {
+                // Trata a volta do contador de 32 bits; a diferença com
+                // sinal também aceita registros dos dois cores levemente
+                // fora de ordem
+                uint32_t tempo = le32(&reg[1]);
+                int64_t us = tempo;
+                if (ultimo >= 0) {
+                    us = ultimo + (int32_t) (tempo - (uint32_t) ultimo);
+                }
+                if (us > ultimo) {
+                    ultimo = us;
+                }
+                trataRegistro(reg, tam, us / 1e6, csv, &res);
+            }
+        }
+        n = 0;
+    }
+    mostraResumo(&res);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file menu.cpp
+ * @author Daniel Quadros
+ * @brief Lógica da configuração pelo encoder
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Apertando o botão entra na configuração, selecionando "Liga".
+ * Girando o encoder altera o valor selecionado. Apertando de novo
+ * passa para "Desliga" e depois sai, salvando se houve alteração.
+ * "Liga" tem que ser menor que "Desliga".
+ * Fora da configuração, girando o encoder troca a página apresentada;
+ * a configuração é sempre feita na página principal.
+ *
+ * Na página da agenda, apertando o botão entra na edição da agenda.
+ * Girando o encoder seleciona a entrada (ou "Sai"); apertando passa
+ * pelos dias, horário (em passos de AG_PASSO_MIN), "Liga" e "Desliga"
+ * da entrada e volta à seleção, já na entrada seguinte. Escolhendo
+ * "Desativada" nos dias volta direto à seleção. Ao sair a agenda é
+ * salva se houve alteração.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include "menu.h"
+
+// Inicia o estado (fora da configuração)
+void menuInit (MENU *menu) {
+    menu->cpo = CPO_NENHUM;
+    menu->pagina = PAG_PRINCIPAL;
+    menu->entrada = 0;
+    menu->mudou = false;
+}
+
+// Troca a página (fora da configuração)
+static void trocaPagina (MENU *menu, int tecla) {
+    if (tecla == TECLA_UP) {
+        menu->pagina = (menu->pagina + 1) % N_PAGINAS;
+    } else {
+        menu->pagina = (menu->pagina + N_PAGINAS - 1) % N_PAGINAS;
+    }
+}
+
+// Altera um valor dentro de uma faixa, retorna true se mudou
+static bool ajusta (int tecla, int *val, int valMin, int valMax) {
+    if ((tecla == TECLA_UP) && (*val < valMax)) {
+        (*val)++;
+        return true;
+    }
+    if ((tecla == TECLA_DN) && (*val > valMin)) {
+        (*val)--;
+        return true;
+    }
+    return false;
+}
+
+// Trata uma tecla, alterando os set points conforme necessário
+// Retorna as ações a executar (MENU_xxx)
+int menuTecla (MENU *menu, int tecla, int *liga, int *desliga) {
+    if (tecla == -1) {
+        return MENU_NADA;
+    }
+    if (menu->cpo == CPO_NENHUM) {
+        if (tecla == TECLA_ENTER) {
+            menu->cpo = CPO_LIGA;     // entra na configuração
+            menu->pagina = PAG_PRINCIPAL;
+            menu->mudou = false;
+        } else {
+            trocaPagina (menu, tecla);
+        }
+        return MENU_TELA;
+    }
+
+    int acao = MENU_TELA;
+    int *pVal = (menu->cpo == CPO_LIGA) ? liga : desliga;
+    int valMin = (menu->cpo == CPO_LIGA) ? 0 : *liga+1;
+    int valMax = (menu->cpo == CPO_LIGA) ? *desliga-1 : 99;
+    if (tecla == TECLA_ENTER) {
+        menu->cpo = (menu->cpo == CPO_LIGA)? CPO_DESLIGA : CPO_NENHUM;
+        if ((menu->cpo == CPO_NENHUM) && menu->mudou) {
+            acao |= MENU_SALVA;
+        }
+    } else if (ajusta (tecla, pVal, valMin, valMax)) {
+        menu->mudou = true;
+    }
+    return acao;
+}
+
+// Trata uma tecla na página da agenda, alterando a agenda
+// Retorna as ações a executar (MENU_xxx)
+int menuAgenda (MENU *menu, int tecla, AGENDA *ag) {
+    if (tecla == -1) {
+        return MENU_NADA;
+    }
+    if (menu->cpo == CPO_NENHUM) {
+        if (tecla == TECLA_ENTER) {
+            menu->cpo = CPO_AG_ENTRADA;     // entra na edição da agenda
+            menu->entrada = 0;
+            menu->mudou = false;
+        } else {
+            trocaPagina (menu, tecla);
+        }
+        return MENU_TELA;
+    }
+
+    int acao = MENU_TELA;
+    if (menu->cpo == CPO_AG_ENTRADA) {
+        if (tecla == TECLA_ENTER) {
+            if (menu->entrada == AGENDA_MAX) {
+                menu->cpo = CPO_NENHUM;
+                if (menu->mudou) {
+                    acao |= MENU_SALVA;
+                }
+            } else {
+                menu->cpo = CPO_AG_DIAS;
+            }
+        } else {
+            int delta = (tecla == TECLA_UP) ? 1 : AGENDA_MAX;
+            menu->entrada = (menu->entrada + delta) % (AGENDA_MAX+1);
+        }
+        return acao;
+    }
+
+    ENTRADA_AGENDA *e = &ag->ent[menu->entrada];
+    int liga = e->liga;
+    int desliga = e->desliga;
+    switch (menu->cpo) {
+        case CPO_AG_DIAS:
+            if (tecla == TECLA_ENTER) {
+                menu->cpo = (e->dias == 0) ? CPO_AG_ENTRADA : CPO_AG_HORA;
+            } else {
+                e->dias = agendaProxDias (e->dias, (tecla == TECLA_UP) ? 1 : -1);
+                menu->mudou = true;
+            }
+            break;
+        case CPO_AG_HORA:
+            if (tecla == TECLA_ENTER) {
+                menu->cpo = CPO_AG_LIGA;
+            } else {
+                int min = (e->minuto / AG_PASSO_MIN) * AG_PASSO_MIN;
+                if (tecla == TECLA_UP) {
+                    min = (min + AG_PASSO_MIN) % MIN_DIA;
+                } else if (min == e->minuto) {
+                    min = (min + MIN_DIA - AG_PASSO_MIN) % MIN_DIA;
+                }
+                e->minuto = (uint16_t) min;
+                menu->mudou = true;
+            }
+            break;
+        case CPO_AG_LIGA:
+            if (tecla == TECLA_ENTER) {
+                menu->cpo = CPO_AG_DESLIGA;
+            } else if (ajusta (tecla, &liga, 0, desliga-1)) {
+                e->liga = (int8_t) liga;
+                menu->mudou = true;
+            }
+            break;
+        case CPO_AG_DESLIGA:
+            if (tecla == TECLA_ENTER) {
+                menu->cpo = CPO_AG_ENTRADA;
+                menu->entrada = (menu->entrada + 1) % (AGENDA_MAX+1);
+            } else if (ajusta (tecla, &desliga, liga+1, 99)) {
+                e->desliga = (int8_t) desliga;
+                menu->mudou = true;
+            }
+            break;
+    }
+    return acao;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file menu.h
+ * @author Daniel Quadros
+ * @brief Lógica da configuração pelo encoder
+ *        Não depende do SDK, é usada também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef MENU_H
+#define MENU_H
+
+#include <stdbool.h>
+
+#include "agenda.h"
+
+// Teclas
+#define TECLA_ENTER 0
+#define TECLA_UP    1
+#define TECLA_DN    2
+
+// Campos durante a configuração
+#define CPO_NENHUM  0
+#define CPO_LIGA    1
+#define CPO_DESLIGA 2
+#define CPO_AG_ENTRADA  3   // agenda: seleção da entrada (ou saída)
+#define CPO_AG_DIAS     4   // agenda: campos da entrada selecionada
+#define CPO_AG_HORA     5
+#define CPO_AG_LIGA     6
+#define CPO_AG_DESLIGA  7
+
+#define AG_PASSO_MIN    15  // passo do horário na agenda (minutos)
+
+// Páginas da tela fora da configuração (trocadas girando o encoder)
+#define PAG_PRINCIPAL   0   // temperatura e set points
+#define PAG_USO         1   // uso do relê
+#define PAG_AGENDA      2   // relógio e agenda
+#define N_PAGINAS       3
+
+// Ações resultantes de uma tecla
+#define MENU_NADA   0x00
+#define MENU_TELA   0x01    // atualizar a tela
+#define MENU_SALVA  0x02    // salvar a configuração
+
+// Estado da configuração
+typedef struct {
+    int cpo;        // campo selecionado
+    int pagina;     // página apresentada fora da configuração
+    int entrada;    // entrada da agenda selecionada (AGENDA_MAX = sair)
+    bool mudou;     // algum valor foi alterado
+} MENU;
+
+// Inicia o estado (fora da configuração)
+void menuInit (MENU *menu);
+
+// Trata uma tecla, alterando os set points conforme necessário
+// Retorna as ações a executar (MENU_xxx)
+int menuTecla (MENU *menu, int tecla, int *liga, int *desliga);
+
+// Trata uma tecla na página da agenda, alterando a agenda
+// Retorna as ações a executar (MENU_xxx)
+int menuAgenda (MENU *menu, int tecla, AGENDA *ag);
+
+#endif
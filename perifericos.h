@@ -0,0 +1,29 @@
+/**
+ * @file perifericos.h
+ * @author Daniel Quadros
+ * @brief Periféricos do termostato, especializados para a placa selecionada
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * No host, host/perifericos_host.h define os mesmos nomes com os
+ * periféricos simulados.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef PERIFERICOS_H
+#define PERIFERICOS_H
+
+#include "placa.h"
+#include "display.h"
+#include "eeprom.h"
+#include "rele.h"
+#include "encoder.h"
+
+typedef Display<PLACA::display> TELA;
+typedef Eeprom<PLACA::eeprom> EEPROM;
+typedef Rele<PLACA::rele> RELE;
+typedef Encoder<PLACA::encoder> ENCODER;
+
+#endif
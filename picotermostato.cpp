@@ -18,122 +18,571 @@
 #include "pico/stdlib.h"
 #include "pico/multicore.h"
 #include "hardware/pio.h"
+#include "hardware/watchdog.h"
+#include "hardware/rtc.h"
 
 #include "picotermostato.h"
+#include "perifericos.h"
+#include "retomada.h"
+#include "comandos.h"
+#include "menu.h"
+#include "termostato.h"
+#include "config.h"
+#include "uso.h"
+#include "agenda.h"
 
 // Controle de acesso à temperatura atual
 static critical_section critTemp;
 
 // Controles do termostato
 static int tempAtual = 20;
-static int tempLiga = 0;
-static int tempDesliga = 0;
-static bool ligado = false;
+// Set points, relê e estado do controle
+// O pedido de modo é alterado pelo core 0, o restante só pelo core 1
+static TERMOSTATO termo;
 
-// Campos durante a configuração
-#define CPO_NENHUM  0
-#define CPO_LIGA    1
-#define CPO_DESLIGA 2
+// Set points pedidos pelo core 0 (configuração, serial e agenda)
+// O par é alterado junto, só pelo core 0 e com critSetPoints, e
+// copiado para termo pelo core 1 no início de cada passo
+static critical_section critSetPoints;
+static int setLiga, setDesliga;
 
-// Estrutura da nossa configuração
+// Estatísticas do controle
+static volatile uint32_t maxPasso = 0;      // us
+
+// Instante da primeira decisão do controle (us desde o reset)
+static volatile uint32_t tPrimeiraDecisao = 0;
+
+// Supervisão pelo watchdog
+// O core 0 só alimenta o watchdog se o core 1 estiver avançando
+#define WDT_TIMEOUT_MS   5000
+#define WDT_MAX_CORE1_MS 3000
+static volatile uint32_t batimento = 0;     // incrementado a cada passo do core 1
+
+// Estado do controle, preservado em reinícios pelo watchdog
+// (esta área não é zerada na partida)
+static AREA_RETOMADA __uninitialized_ram(areaRetomada);
+static uint32_t seqRetomada;
+
+// Configuração (mantida em RAM, gravada de forma adiada)
+static GERCONFIG gerConfig;
+
+// Uso do relê
+// Atualizado pelo core 1 a cada passo, consultado e gravado pelo core 0
+static critical_section critUso;
+static USO uso;
+static uint32_t seqUso;
+
+// Agenda semanal
+// A agenda é editada pelo core 0; a tabela compilada é consultada
+// pelo core 1 a cada passo. Os set points de uma transição que entrou
+// em vigor são deixados pelo core 1 para o core 0 aplicar (com
+// critAgenda; com mais de uma transição pendente vale a última)
+static critical_section critAgenda;
+static AGENDA agenda;
+static TABELA_AGENDA tabAgenda;
+static uint32_t seqAgenda;
+static bool mudouAgenda = false;
+static int agendaLiga, agendaDesliga;
+
+// Relógio salvo no estado retomado (-1 se não estava acertado)
+static int32_t relogioRetomado = -1;
+
+// Instante da última atualização da tela (ms)
+static uint32_t tTela = 0;
+
+// Configuração no formato antigo (duas cópias em CFG_V0_ADDR),
+// lida somente para migração
 typedef struct {
     int tempOn;
     int tempOff;
     int chksum;
-} CONFIG;
-
-// Onde a configuração é salva na EEPROM
-// Gravamos duas cópias para o caso de perder a alimentação
-// durante a gravação
-#define CFG1_ADDR 0
-#define CFG2_ADDR sizeof(CONFIG)
-
-// Salva a configuração na EEPROM
-void salvaConfig() {
-    CONFIG cfg;
-    cfg.tempOn = tempLiga;
-    cfg.tempOff = tempDesliga;
-    cfg.chksum = cfg.tempOn + cfg.tempOff;
-    eepromWrite((uint8_t *) &cfg, CFG1_ADDR, sizeof(cfg));
-    eepromWrite((uint8_t *) &cfg, CFG2_ADDR, sizeof(cfg));
-}
-
-// Le a configuração da EEPROM
-void leConfig() {
-    CONFIG cfg;
-    uint16_t addr = CFG1_ADDR;
-
-    do {
-        if (eepromRead((uint8_t *) &cfg, addr, sizeof(cfg))) {
-            if (cfg.chksum == (cfg.tempOn + cfg.tempOff)) {
-                tempLiga = cfg.tempOn;
-                tempDesliga = cfg.tempOff;
-                return;
+} CONFIG_V0;
+
+// Funções usadas pelo gerenciador da configuração
+bool appEepromLe (uint8_t *buffer, uint32_t addr, int n) {
+    return EEPROM::read(buffer, addr, n);
+}
+
+bool appEepromGrava (const uint8_t *buffer, uint32_t addr, int n) {
+    return EEPROM::write(buffer, addr, n);
+}
+
+// Muda os set points (só no core 0)
+static void mudaSetPoints(int liga, int desliga) {
+    critical_section_enter_blocking(&critSetPoints);
+    setLiga = liga;
+    setDesliga = desliga;
+    critical_section_exit(&critSetPoints);
+}
+
+// Registra os set points atuais na configuração
+// A gravação na EEPROM é feita depois, por configPoll
+static void salvaConfig() {
+    CONFIG cfg = gerConfig.atual;
+    cfg.tempLiga = setLiga;
+    cfg.tempDesliga = setDesliga;
+    configMuda(&gerConfig, &cfg, to_ms_since_boot(get_absolute_time()));
+}
+
+// Registra na configuração os tempos aprendidos pela antecipação,
+// quando mudam mais que ANT_TOLERANCIA segundos (só são aprendidos
+// no modo CTL_ANTECIPA)
+// Os campos são atualizados só pelo core 1, em 32 bits (a leitura
+// de cada um é atômica)
+#define ANT_TOLERANCIA  5
+static void salvaAntecipacao() {
+    if (termo.controle.modo != CTL_ANTECIPA) {
+        return;
+    }
+    CONFIG cfg = gerConfig.atual;
+    uint16_t liga = (uint16_t) (termo.controle.ant.taLiga / 1000);
+    uint16_t desliga = (uint16_t) (termo.controle.ant.taDesliga / 1000);
+    if ((abs(liga - cfg.antLiga) > ANT_TOLERANCIA) ||
+        (abs(desliga - cfg.antDesliga) > ANT_TOLERANCIA)) {
+        cfg.antLiga = liga;
+        cfg.antDesliga = desliga;
+        configMuda(&gerConfig, &cfg, to_ms_since_boot(get_absolute_time()));
+    }
+}
+
+// Carrega a configuração da EEPROM
+// Se não tiver uma válida, tenta converter a do formato antigo; a
+// conversão é gravada já, exceto numa retomada (fica para configPoll)
+static void leConfig(bool retomou) {
+    if (configInit(&gerConfig, CFG_ADDR, EEPROM::pagina()) == CFG_LIDA) {
+        return;
+    }
+    CONFIG cfg = gerConfig.atual;
+    for (int i = 0; i < 2; i++) {
+        CONFIG_V0 antiga;
+        if (EEPROM::read((uint8_t *) &antiga, CFG_V0_ADDR + i*sizeof(CONFIG_V0), sizeof(antiga)) &&
+            (antiga.chksum == (antiga.tempOn + antiga.tempOff))) {
+            printf ("Convertendo configuracao do formato antigo\n");
+            cfg.tempLiga = antiga.tempOn;
+            cfg.tempDesliga = antiga.tempOff;
+            break;
+        }
+    }
+    configMuda(&gerConfig, &cfg, 0);
+    if (!retomou && !configGrava(&gerConfig)) {
+        printf ("Erro ao gravar a configuracao\n");
+    }
+}
+
+// Segundo da semana pelo RTC, -1 se não foi acertado
+// O RTC é acessado pelos dois cores, chamar com critAgenda
+static int32_t segundoSemana() {
+    datetime_t dt;
+    if (!rtc_get_datetime(&dt)) {
+        return -1;
+    }
+    return (dt.dotw*MIN_DIA + dt.hour*60 + dt.min)*60 + dt.sec;
+}
+
+// Minuto da semana, para o core 0
+static int relogio() {
+    critical_section_enter_blocking(&critAgenda);
+    int32_t seg = segundoSemana();
+    critical_section_exit(&critAgenda);
+    return (seg < 0) ? -1 : (int) (seg / 60);
+}
+
+// Acerta o RTC no segundo da semana indicado
+// A data é a de um dia da semana correspondente (4/1/2026 é um
+// domingo), só o dia da semana e o horário são usados
+static void acertaRelogio(int32_t seg) {
+    int32_t min = (seg / 60) % MIN_SEMANA;
+    datetime_t dt;
+    dt.year = 2026;
+    dt.month = 1;
+    dt.day = 4 + min / MIN_DIA;
+    dt.dotw = min / MIN_DIA;
+    dt.hour = (min % MIN_DIA) / 60;
+    dt.min = min % 60;
+    dt.sec = seg % 60;
+    critical_section_enter_blocking(&critAgenda);
+    rtc_set_datetime(&dt);
+    critical_section_exit(&critAgenda);
+}
+
+// Passa a usar a agenda
+static void usaAgenda() {
+    TABELA_AGENDA nova;
+    agendaCompila(&agenda, &nova);
+    critical_section_enter_blocking(&critAgenda);
+    tabAgenda = nova;
+    critical_section_exit(&critAgenda);
+}
+
+// Passa a usar a agenda alterada e grava na EEPROM
+static void mudaAgenda() {
+    usaAgenda();
+    if (!agendaGrava(&agenda, AGENDA_ADDR, &seqAgenda)) {
+        printf ("Erro ao gravar a agenda\n");
+    }
+}
+
+// Página do relógio e da agenda
+static void telaAgenda(const MENU *menu) {
+    char linha[16];
+    int min = relogio();
+
+    TELA::clear();
+    if (min < 0) {
+        TELA::str(0,0, "Sem hora");
+    } else {
+        snprintf(linha, sizeof(linha), "%s %02d:%02d", agendaNomeDia(min / MIN_DIA),
+                 (min % MIN_DIA) / 60, min % 60);
+        TELA::str(0,0, linha);
+    }
+
+    if (menu->cpo == CPO_NENHUM) {
+        // Número de entradas e próxima transição
+        int n = 0;
+        for (int i = 0; i < AGENDA_MAX; i++) {
+            if (agenda.ent[i].dias != 0) {
+                n++;
             }
         }
-        if (addr == CFG1_ADDR) {
-            // Tenta a segunda cópia
-            printf ("Tentando segunda copia da configuracao\n");
-            addr = CFG2_ADDR;
-        } else {
-            // Usar default
-            printf ("Usando configuracao padrao\n");
-            tempLiga = 20;
-            tempDesliga = 25;
-            salvaConfig();
-            return;
+        snprintf(linha, sizeof(linha), "Agenda %d", n);
+        TELA::str(1,0, linha);
+        TRANSICAO prox;
+        critical_section_enter_blocking(&critAgenda);
+        bool temProx = agendaProxima(&tabAgenda, &prox);
+        critical_section_exit(&critAgenda);
+        if (temProx) {
+            snprintf(linha, sizeof(linha), "Prox %s", agendaNomeDia(prox.minSemana / MIN_DIA));
+            TELA::str(3,0, linha);
+            snprintf(linha, sizeof(linha), "     %02d:%02d", (prox.minSemana % MIN_DIA) / 60,
+                     prox.minSemana % 60);
+            TELA::str(4,0, linha);
+            snprintf(linha, sizeof(linha), "L %d D %d", prox.liga, prox.desliga);
+            TELA::str(5,0, linha);
+        }
+    } else if (menu->entrada == AGENDA_MAX) {
+        TELA::str(1,0, ">Sai");
+    } else {
+        // Edição de uma entrada, o campo selecionado é marcado com '>'
+        const ENTRADA_AGENDA *e = &agenda.ent[menu->entrada];
+        snprintf(linha, sizeof(linha), "%cEntrada %d", (menu->cpo == CPO_AG_ENTRADA) ? '>' : ' ',
+                 menu->entrada);
+        TELA::str(1,0, linha);
+        snprintf(linha, sizeof(linha), "%c%s", (menu->cpo == CPO_AG_DIAS) ? '>' : ' ',
+                 agendaNomeDias(e->dias));
+        TELA::str(2,0, linha);
+        if (e->dias != 0) {
+            snprintf(linha, sizeof(linha), "%c%02d:%02d", (menu->cpo == CPO_AG_HORA) ? '>' : ' ',
+                     e->minuto / 60, e->minuto % 60);
+            TELA::str(3,0, linha);
+            snprintf(linha, sizeof(linha), "%cLiga %d", (menu->cpo == CPO_AG_LIGA) ? '>' : ' ',
+                     e->liga);
+            TELA::str(4,0, linha);
+            snprintf(linha, sizeof(linha), "%cDesl %d", (menu->cpo == CPO_AG_DESLIGA) ? '>' : ' ',
+                     e->desliga);
+            TELA::str(5,0, linha);
         }
-    } while (true);
+    }
+    TELA::refresh();
+}
+
+// Formata uma contagem para a tela, no máximo 4 caracteres
+static void contagem(char *txt, size_t tam, uint32_t n) {
+    if (n > 999) {
+        snprintf(txt, tam, ">999");
+    } else {
+        snprintf(txt, tam, "%lu", (unsigned long) n);
+    }
+}
+
+// Página com o uso do relê
+static void telaUso() {
+    USO_RESUMO r;
+    char linha[16];
+    char cont[8];
+
+    critical_section_enter_blocking(&critUso);
+    usoResumo(&uso, to_ms_since_boot(get_absolute_time()), &r);
+    critical_section_exit(&critUso);
+
+    TELA::clear();
+    snprintf(linha, sizeof(linha), "Ligado%5luh", (unsigned long) r.total.segLigado / 3600);
+    TELA::str(0,0, linha);
+    snprintf(linha, sizeof(linha), "Hora %3u.%u%%", r.cicloHora / 10, r.cicloHora % 10);
+    TELA::str(1,0, linha);
+    snprintf(linha, sizeof(linha), "24h  %3u.%u%%", r.ciclo24h / 10, r.ciclo24h % 10);
+    TELA::str(2,0, linha);
+    snprintf(linha, sizeof(linha), "Dias %3u.%u%%", r.cicloDias / 10, r.cicloDias % 10);
+    TELA::str(3,0, linha);
+    contagem(cont, sizeof(cont), r.ciclos24h);
+    snprintf(linha, sizeof(linha), "Ciclos %s", cont);
+    TELA::str(4,0, linha);
+    contagem(cont, sizeof(cont), r.curtos24h);
+    snprintf(linha, sizeof(linha), r.alerta ? "CURTOS %s" : "Curtos %s", cont);
+    TELA::str(5,0, linha);
+    TELA::refresh();
 }
 
 // Atualiza a tela
-static void atualizaTela(int cpo) {
-    displayClear();
-    displayStr(0,0, "Atual");
-    displayDigDD(0, 6, tempAtual / 10);
-    displayDigDD(0, 8, tempAtual % 10);
-    if (ligado) {
-        displayCar(0, 11, '*');
+static void atualizaTela(const MENU *menu) {
+    tTela = to_ms_since_boot(get_absolute_time());
+    if (menu->pagina == PAG_USO) {
+        telaUso();
+        return;
+    }
+    if (menu->pagina == PAG_AGENDA) {
+        telaAgenda(menu);
+        return;
+    }
+    int cpo = menu->cpo;
+    TELA::clear();
+    TELA::str(0,0, "Atual");
+    TELA::digDD(0, 6, tempAtual / 10);
+    TELA::digDD(0, 8, tempAtual % 10);
+    if (termo.ligado) {
+        TELA::car(0, 11, '*');
     }
     switch (cpo) {
         case CPO_NENHUM:
-            displayStr(3,0, "Liga Desliga");
+            TELA::str(3,0, "Liga Desliga");
             break;
         case CPO_LIGA:
-            displayStr(3,0, "LIGA Desliga");
+            TELA::str(3,0, "LIGA Desliga");
             break;
         case CPO_DESLIGA:
-            displayStr(3,0, "Liga DESLIGA");
+            TELA::str(3,0, "Liga DESLIGA");
             break;
     }
-    displayDigDD(4, 0, tempLiga / 10);
-    displayDigDD(4, 2, tempLiga % 10);
-    displayDigDD(4, 5, tempDesliga / 10);
-    displayDigDD(4, 7, tempDesliga % 10);
-    displayRefresh();
+    TELA::digDD(4, 0, setLiga / 10);
+    TELA::digDD(4, 2, setLiga % 10);
+    TELA::digDD(4, 5, setDesliga / 10);
+    TELA::digDD(4, 7, setDesliga % 10);
+    TELA::refresh();
 }
 
 // Lógica do termostato
 static void termostato() {
+    // A iniciação dos sensores é feita aqui, em paralelo com o
+    // restante da iniciação no core 0
+    sensorInit(true);
+
     while (true) {
         // Provavelmente um exagero usar critical_section nesse
         // caso, mas vamos pela segurança
-        int tempNova = sensorLe();
+        uint32_t t0 = time_us_32();
+        int32_t tempNova = sensorLe();
+        uint32_t t1 = time_us_32();
         critical_section_enter_blocking(&critTemp);
-        tempAtual = tempNova;
+        tempAtual = TEMP_GRAUS(tempNova);
         critical_section_exit(&critTemp);
 
+        // Set points da agenda, se entrou em vigor outra transição
+        // (normalmente só uma comparação), aplicados pelo core 0
+        int liga, desliga;
+        critical_section_enter_blocking(&critAgenda);
+        int32_t seg = segundoSemana();
+        if (agendaPasso(&tabAgenda, (seg < 0) ? -1 : (int) (seg / 60), &liga, &desliga)) {
+            agendaLiga = liga;
+            agendaDesliga = desliga;
+            mudouAgenda = true;
+        }
+        critical_section_exit(&critAgenda);
+
+        // Set points pedidos pelo core 0, sempre o par
+        critical_section_enter_blocking(&critSetPoints);
+        termo.tempLiga = setLiga;
+        termo.tempDesliga = setDesliga;
+        critical_section_exit(&critSetPoints);
+
         // Aciona ou desaciona o rele conforme necessário
-        bool ligarRele = ligado;
-        if (tempAtual < tempLiga) {
-            ligarRele = true;
-        } else if (tempAtual > tempDesliga) {
-            ligarRele = false;;
+        // Sem sensor o relê fica desligado
+        uint32_t agora = to_ms_since_boot(get_absolute_time());
+        bool trocou = sensorFalta() ? termostatoSemSensor(&termo, agora) :
+                                      termostatoPasso(&termo, tempNova, agora);
+        if (trocou) {
+            RELE::aciona(termo.ligado);
+            telRele(termo.ligado);
+        }
+        critical_section_enter_blocking(&critUso);
+        if (trocou) {
+            usoTroca(&uso, termo.ligado, agora);
+        } else {
+            usoPoll(&uso, agora);
         }
-        if (ligarRele != ligado) {
-            gpio_put(PIN_RELE, ligarRele);
-            ligado = ligarRele;
+        critical_section_exit(&critUso);
+        uint32_t tPasso = time_us_32() - t0;
+        if (tPasso > maxPasso) {
+            maxPasso = tPasso;
         }
+        telPasso(t1 - t0, time_us_32() - t1);
+        telTemperatura(tempNova, termo.controle.saida, termo.controle.modo);
+        if (tPrimeiraDecisao == 0) {
+            tPrimeiraDecisao = to_us_since_boot(get_absolute_time());
+        }
+
+        // Salva o estado para uma eventual retomada
+        ESTADO_CTL est;
+        est.temp = tempNova;
+        est.tempLiga = termo.tempLiga;
+        est.tempDesliga = termo.tempDesliga;
+        est.ligado = termo.ligado;
+        est.agora = to_ms_since_boot(get_absolute_time());
+        est.relogio = seg;
+        est.controle = termo.controle;
+        retomadaSalva(&areaRetomada, &seqRetomada, &est);
+        batimento++;
+    }
+}
+
+// Tenta retomar o controle após um reinício pelo watchdog
+// Se conseguir, o relê volta ao estado anterior
+static bool retomaControle() {
+    ESTADO_CTL est;
+
+    if (!watchdog_caused_reboot() ||
+        !retomadaRestaura(&areaRetomada, &est, &seqRetomada)) {
+        retomadaInvalida(&areaRetomada);
+        seqRetomada = 0;
+        return false;
+    }
+    termostatoInit(&termo, MODO_CONTROLE, est.tempLiga, est.tempDesliga);
+    mudaSetPoints(est.tempLiga, est.tempDesliga);
+    relogioRetomado = est.relogio;
+    termo.ligado = est.ligado;
+    termo.temp = est.temp;
+    tempAtual = TEMP_GRAUS(est.temp);
+    termo.controle = est.controle;
+    controleAjustaTempo(&termo.controle, to_ms_since_boot(get_absolute_time()) - est.agora);
+    return true;
+}
+
+// Alimenta o watchdog se o core 1 estiver funcionando
+static void supervisiona() {
+    static uint32_t batAnt = 0;
+    static uint32_t tBat = 0;
+    uint32_t agora = to_ms_since_boot(get_absolute_time());
+
+    if (batimento != batAnt) {
+        batAnt = batimento;
+        tBat = agora;
+    }
+    if ((agora - tBat) < WDT_MAX_CORE1_MS) {
+        watchdog_update();
+    }
+}
+
+// Grava os totais do uso do relê a cada hora fechada e, uma vez,
+// num aviso de falta de energia
+static void salvaUso(bool faltando) {
+    static bool salvouFalta = false;
+    USO_TOTAL total;
+
+    critical_section_enter_blocking(&critUso);
+    bool gravar = uso.gravar || (faltando && !salvouFalta);
+    uso.gravar = false;
+    usoTotal(&uso, to_ms_since_boot(get_absolute_time()), &total);
+    critical_section_exit(&critUso);
+    salvouFalta = faltando;
+
+    // A gravação é feita fora da seção crítica, para não segurar o core 1
+    if (gravar && !usoGrava(&total, USO_ADDR, &seqUso)) {
+        printf ("Erro ao gravar o uso do rele\n");
+    }
+}
+
+// Funções usadas pelo interpretador de comandos
+
+// Indica que os set points foram mudados pela serial
+static bool mudouSerial = false;
+
+void appLeSetPoints (int *liga, int *desliga) {
+    *liga = setLiga;
+    *desliga = setDesliga;
+}
+
+void appMudaSetPoints (int liga, int desliga) {
+    mudaSetPoints(liga, desliga);
+    mudouSerial = true;
+}
+
+// Pedido explícito pela serial, grava imediatamente
+void appSalvaConfig () {
+    printf ("Salvando configuracao\n");
+    salvaConfig();
+    configGrava(&gerConfig);
+    telConfig(setLiga, setDesliga);
+}
+
+int32_t appTemperatura () {
+    return termo.temp;
+}
+
+bool appRele () {
+    return termo.ligado;
+}
+
+int appModo () {
+    return termo.controle.modo;
+}
+
+void appPedeModo (int modo) {
+    termostatoPedeModo(&termo, modo);
+}
+
+int appSensores (int32_t *temps, int max) {
+    return sensorUltimas(temps, max);
+}
+
+void appEstatisticas (CMD_ESTAT *est) {
+    est->tempo = to_ms_since_boot(get_absolute_time());
+    est->passos = batimento;
+    est->trocas = termo.nTrocas;
+    est->maxPasso = maxPasso;
+    est->primeiraDecisao = tPrimeiraDecisao;
+    est->saida = termo.controle.saida;
+    est->par = termo.controle.par;
+    est->antLiga = termo.controle.ant.taLiga;
+    est->antDesliga = termo.controle.ant.taDesliga;
+    est->nMedidas = termo.controle.ant.nMedidas;
+}
+
+void appUso (USO_RESUMO *res) {
+    critical_section_enter_blocking(&critUso);
+    usoResumo(&uso, to_ms_since_boot(get_absolute_time()), res);
+    critical_section_exit(&critUso);
+}
+
+bool appLeHora (int *dia, int *minuto) {
+    int min = relogio();
+    if (min < 0) {
+        return false;
+    }
+    *dia = min / MIN_DIA;
+    *minuto = min % MIN_DIA;
+    return true;
+}
+
+void appAcertaHora (int dia, int minuto) {
+    acertaRelogio((dia*MIN_DIA + minuto) * 60);
+}
+
+void appLeAgenda (AGENDA *ag) {
+    *ag = agenda;
+}
+
+void appMudaAgenda (const AGENDA *ag) {
+    agenda = *ag;
+    mudaAgenda();
+}
+
+void appEscreve (const char *txt) {
+    printf ("%s\n", txt);
+}
+
+// Trata os caracteres recebidos pela serial, sem esperar
+static void trataSerial (INTERPRETADOR *interp) {
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        cmdRecebe(interp, (char) c);
     }
 }
 
@@ -141,87 +590,205 @@ static void termostato() {
 int main() {
     int tempAnt;
 
-    // Inicia rele
-    gpio_init(PIN_RELE);
-    gpio_set_dir(PIN_RELE, true);
-    gpio_put(PIN_RELE, false);
+    // Clocks (reduzidos no modo de economia), antes dos periféricos
+    energiaInit();
 
-    // Inicia stdio para debug
-    stdio_init_all();
+    // Se foi um reinício pelo watchdog, retoma de onde parou
+    critical_section_init(&critSetPoints);
+    bool retomou = retomaControle();
 
-    // Inicia display
-    displayInit();
-    displayStr(0,0, "DQSoft 2.00");
-    displayStr(2,0, "Termostato");
-    displayRefresh();
+    // Inicia rele (já no estado retomado)
+    RELE::init(termo.ligado);
+    uint32_t tRele = to_us_since_boot(get_absolute_time());
 
-    // Inicia encoder
-    encoderInit(pio0, PIN_ENC_CLK, PIN_ENC_DT, PIN_ENC_SW);
+    // Inicia stdio para debug e a telemetria
+    stdio_init_all();
+    telemetriaInit();
+    if (retomou) {
+        printf ("Reinicio pelo watchdog, controle retomado (rele restaurado em %lu us)\n",
+                (unsigned long) tRele);
+    }
 
-    // Inicia Sensores
+    // Acesso à EEPROM (os endereços dos sensores estão nela)
+    EEPROM::init();
+
+    // Relógio, o RTC só passa a funcionar quando for acertado
+    // Numa retomada o RTC é mantido se continuou funcionando; se foi
+    // reiniciado junto com o restante do chip, volta à hora salva no
+    // estado mais o tempo desde o reinício (perdendo só o intervalo
+    // até o watchdog atuar)
+    critical_section_init(&critAgenda);
+    if (!retomou || !rtc_running()) {
+        rtc_init();
+        if (retomou && (relogioRetomado >= 0)) {
+            acertaRelogio(relogioRetomado + (int32_t) (to_ms_since_boot(get_absolute_time()) / 1000));
+        }
+    }
+    critical_section_init(&critUso);
     critical_section_init(&critTemp);
-    sensorInit();
-    tempAnt = tempAtual = sensorLe();
+
+    // Numa retomada a lógica do termostato volta a rodar já, com o
+    // estado retomado; a agenda (por enquanto vazia) e os totais do uso
+    // são lidos da EEPROM em seguida, com o controle funcionando
+    if (retomou) {
+        USO_TOTAL zero;
+        memset(&zero, 0, sizeof(zero));
+        usoInit(&uso, &zero, termo.ligado, to_ms_since_boot(get_absolute_time()));
+        multicore_launch_core1 (termostato);
+    }
 
     // Inicia configuração
-    eepromInit(PIN_SDA, PIN_SCL);
-    leConfig();
+    // (numa partida normal precisa vir antes do controle, por causa
+    // dos set points)
+    // Numa retomada as cópias também são lidas: o gerenciador precisa
+    // da sequência e do conteúdo de cada cópia para as gravações
+    // seguintes. A retomada só causa gravação se os set points
+    // retomados forem diferentes dos gravados, e mesmo assim adiada
+    leConfig(retomou);
+    if (retomou) {
+        if ((setLiga != gerConfig.atual.tempLiga) ||
+            (setDesliga != gerConfig.atual.tempDesliga)) {
+            salvaConfig();
+        }
+    } else {
+        termostatoInit(&termo, MODO_CONTROLE, gerConfig.atual.tempLiga, gerConfig.atual.tempDesliga);
+        mudaSetPoints(gerConfig.atual.tempLiga, gerConfig.atual.tempDesliga);
+        controleAntecipacao(&termo.controle, gerConfig.atual.antLiga*1000u,
+                            gerConfig.atual.antDesliga*1000u);
+    }
+    if (PLACA::avisoFalha >= 0) {
+        gpio_init(PLACA::avisoFalha);
+        gpio_set_dir(PLACA::avisoFalha, GPIO_IN);
+        gpio_pull_up(PLACA::avisoFalha);
+    }
+
+    // Agenda semanal
+    agendaCarrega(&agenda, AGENDA_ADDR, &seqAgenda);
+    usaAgenda();
+
+    // Contabilização do uso do relê, a partir dos totais gravados
+    USO_TOTAL totalUso;
+    if (!usoCarrega(&totalUso, USO_ADDR, &seqUso)) {
+        printf ("Iniciando a contabilizacao do rele\n");
+    }
+    if (retomou) {
+        critical_section_enter_blocking(&critUso);
+        usoSomaTotal(&uso, &totalUso);
+        critical_section_exit(&critUso);
+    } else {
+        usoInit(&uso, &totalUso, termo.ligado, to_ms_since_boot(get_absolute_time()));
+
+        // Lógica do termostato roda no outro core, começa o quanto antes
+        // A primeira conversão dos sensores ocorre enquanto o core 0
+        // inicia o display e o encoder
+        multicore_launch_core1 (termostato);
+    }
+
+    // Inicia display
+    TELA::init();
+    TELA::str(0,0, "DQSoft 2.00");
+    TELA::str(2,0, "Termostato");
+    TELA::refresh();
+
+    // Inicia encoder
+    ENCODER::init();
+
+    // Aguarda a primeira leitura dos sensores
+    while (tPrimeiraDecisao == 0) {
+        sleep_ms(1);
+    }
+    printf ("Primeira decisao de controle em %lu us\n", (unsigned long) tPrimeiraDecisao);
+    critical_section_enter_blocking(&critTemp);
+    tempAnt = tempAtual;
+    critical_section_exit(&critTemp);
 
     // Inicia a tela
-    int cpo = CPO_NENHUM;
-    atualizaTela (cpo);
+    MENU menu;
+    menuInit (&menu);
+    atualizaTela (&menu);
+
+    // Inicia o interpretador de comandos
+    INTERPRETADOR interp;
+    cmdInit(&interp);
 
-    // Lógica do termostato roda no outro core
-    multicore_launch_core1 (termostato);
+    // Daqui para frente o funcionamento é supervisionado pelo watchdog
+    watchdog_enable(WDT_TIMEOUT_MS, true);
 
     // Laço principal (core 0)
     while (true) {
         // Trata teclado
-        int tec = tecLe();
-        bool mudou;
-        if (cpo == CPO_NENHUM) {
-            if (tec == TECLA_ENTER) {
-                cpo = CPO_LIGA;     // entra na configuração
-                mudou = false;
-                atualizaTela(cpo);
-            } else {  // ignora outras teclas fora da configuração
-                int tempNova;
-                critical_section_enter_blocking(&critTemp);
-                tempNova = tempAtual;
-                critical_section_exit(&critTemp);
-                if (tempAnt != tempNova) {
-                    // Atualiza temperatura
-                    atualizaTela(cpo);
-                    tempAnt = tempNova;
-                }
-            } 
-        } else if (tec != -1) {
-            int *pVal = (cpo == CPO_LIGA) ? &tempLiga : &tempDesliga;
-            int valMin = (cpo == CPO_LIGA) ? 0 : tempLiga+1;
-            int valMax = (cpo == CPO_LIGA) ? tempDesliga-1 : 99;
-            switch (tec) {
-                case TECLA_UP:
-                    if (*pVal < valMax) {
-                        (*pVal)++;
-                        mudou = true;
-                    }
-                    break;
-                case TECLA_DN:
-                    if (*pVal > valMin) {
-                        (*pVal)--;
-                        mudou = true;
-                    }
-                    break;
-                case TECLA_ENTER:
-                    cpo = (cpo == CPO_LIGA)? CPO_DESLIGA : CPO_NENHUM;
-                    if ((cpo == CPO_NENHUM) && mudou) {
-                        printf ("Salvando configuracao\n");
-                        salvaConfig();
-                    }
-                    break;
+        int tec = ENCODER::tecLe();
+        if (tec != -1) {
+            telTecla(tec);
+        }
+        int liga, desliga;
+        critical_section_enter_blocking(&critAgenda);
+        bool agendou = mudouAgenda;
+        mudouAgenda = false;
+        liga = agendaLiga;
+        desliga = agendaDesliga;
+        critical_section_exit(&critAgenda);
+        if (agendou) {
+            // Set points mudados pela agenda
+            mudaSetPoints(liga, desliga);
+            telAgenda(setLiga, setDesliga);
+        }
+        if ((menu.cpo == CPO_NENHUM) && (tec != TECLA_ENTER)) {
+            int tempNova;
+            critical_section_enter_blocking(&critTemp);
+            tempNova = tempAtual;
+            critical_section_exit(&critTemp);
+            // As páginas do uso do relê e do relógio mudam
+            // continuamente, são atualizadas a cada segundo
+            bool atualizaPagina = (menu.pagina != PAG_PRINCIPAL) &&
+                ((to_ms_since_boot(get_absolute_time()) - tTela) >= 1000);
+            if ((tempAnt != tempNova) || mudouSerial || agendou || atualizaPagina) {
+                // Atualiza temperatura
+                atualizaTela(&menu);
+                tempAnt = tempNova;
+                mudouSerial = false;
             }
-            atualizaTela(cpo);
         }
-        sleep_ms(50);
+        int acao;
+        if (menu.pagina == PAG_AGENDA) {
+            acao = menuAgenda(&menu, tec, &agenda);
+            if (acao & MENU_SALVA) {
+                mudaAgenda();
+            }
+        } else {
+            liga = setLiga;
+            desliga = setDesliga;
+            acao = menuTecla(&menu, tec, &liga, &desliga);
+            if ((liga != setLiga) || (desliga != setDesliga)) {
+                mudaSetPoints(liga, desliga);
+            }
+            if (acao & MENU_SALVA) {
+                salvaConfig();
+                telConfig(setLiga, setDesliga);
+            }
+        }
+        if (acao & MENU_TELA) {
+            atualizaTela(&menu);
+        }
+        trataSerial(&interp);
+
+        // Grava a configuração alterada depois de um tempo sem
+        // alterações, ou já se estiver faltando energia
+        bool faltando = (PLACA::avisoFalha >= 0) && !gpio_get(PLACA::avisoFalha);
+        salvaUso(faltando);
+        salvaAntecipacao();
+        if (faltando) {
+            configGrava(&gerConfig);
+        } else if (configPoll(&gerConfig, to_ms_since_boot(get_absolute_time()))) {
+            printf ("Configuracao gravada (%lu paginas ate agora)\n", (unsigned long) gerConfig.nPaginas);
+        }
+        supervisiona();
+        telemetriaPoll();
+
+        // Espera o próximo ciclo com o core parado, acordando antes
+        // se chegar uma tecla
+        absolute_time_t limite = make_timeout_time_ms(50);
+        while (!ENCODER::temTecla() && !energiaEspera(limite)) {
+        }
     }
 }
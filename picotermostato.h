@@ -9,49 +9,41 @@
  * 
  */
 
-// Conexões do circuito
-#define PIN_SENSOR 10
+#include "controle.h"
+#include "menu.h"
 
-#define PIN_ENC_SW     11
-#define PIN_ENC_DT     12
-#define PIN_ENC_CLK    13
+// Seleção do modo de controle (CTL_HISTERESE, CTL_PID ou CTL_ANTECIPA)
+#define MODO_CONTROLE CTL_HISTERESE
 
-#define SPI_ID spi1
-#define PIN_SCLK  14
-#define PIN_SDIN  15
-#define PIN_DC    18
-#define PIN_RESET 19
-#define PIN_SCE   20
+// As conexões do circuito estão em placa.h e os drivers dos
+// periféricos em perifericos.h
 
-#define PIN_RELE  21
-
-#define I2C_ID i2c1
-#define PIN_SDA  26
-#define PIN_SCL  27
-
-// Teclas
-#define TECLA_ENTER 0
-#define TECLA_UP    1
-#define TECLA_DN    2
-
-// Encoder
-void encoderInit (PIO pio, uint pin_a, uint pin_b, uint pin_sw);
-int tecLe (void);
-
-// Display
-void displayInit (void);
-void displayRefresh (void);
-void displayCar (int l, int c, char car);
-void displayStr (int l, int c, const char *str);
-void displayDigDD (int l, int c, char dig);
-void displayClear (void);
+// Mapa da EEPROM
+#define CFG_V0_ADDR 0           // configuração no formato antigo (só para conversão)
+#define SENSOR_CACHE_ADDR 32    // endereços dos sensores
+#define CFG_ADDR 64             // configuração (duas cópias de CFG_TAM_COPIA, ver config.h)
+#define USO_ADDR 192            // totais do uso do relê (duas cópias de USO_TAM_COPIA, ver uso.h)
+#define AGENDA_ADDR 256         // agenda semanal (duas cópias de AGENDA_TAM_COPIA, ver agenda.h)
+// O último byte dos primeiros 4K (EE_SONDA) é reservado para o driver (ver eeprom.h)
 
 // Sensor
-void sensorInit (void);
-int sensorLe (void);
-
-// EEProm
-void eepromInit(uint pinSDA, uint pinSCL);
-bool eepromRead(uint8_t *buffer, uint16_t addr, int n);
-bool eepromWrite(uint8_t *buffer, uint16_t addr, int n);
-
+void sensorInit (bool rapido);
+int32_t sensorLe (void);
+bool sensorFalta (void);
+int sensorUltimas (int32_t *temps, int max);
+
+// Economia de energia
+void energiaInit (void);
+bool energiaEspera (absolute_time_t limite);
+void energiaDorme (uint32_t ms);
+
+// Telemetria
+void telemetriaInit (void);
+void telemetriaPoll (void);
+void telTemperatura (int32_t temp, int saida, int modo);
+void telSensor (int sensor, int32_t temp);
+void telRele (bool ligado);
+void telPasso (uint32_t usLeitura, uint32_t usControle);
+void telTecla (int tecla);
+void telConfig (int liga, int desliga);
+void telAgenda (int liga, int desliga);
@@ -0,0 +1,118 @@
+/**
+ * @file placa.h
+ * @author Daniel Quadros
+ * @brief Descrição das conexões da placa, resolvida em tempo de compilação
+ *        Não depende do SDK, é usada também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Cada periférico é descrito por uma estrutura constexpr; os drivers
+ * (display.h, eeprom.h, rele.h, encoder.h) são templates que recebem
+ * essa descrição. O compilador gera um driver especializado para cada
+ * periférico, com os pinos e os blocos de hardware como constantes,
+ * e vários periféricos do mesmo tipo podem coexistir.
+ *
+ * A placa usada é escolhida pelo define PLACA. No host, perifericos.h
+ * é substituído por host/perifericos_host.h, que usa os mesmos
+ * templates com periféricos simulados.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef PLACA_H
+#define PLACA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Display Nokia 5110 ligado a um SPI
+typedef struct {
+    uint8_t spi;            // 0 = spi0, 1 = spi1
+    uint8_t sclk, sdin;     // pinos do SPI
+    uint8_t dc, reset, sce; // pinos de controle
+    uint32_t baud;
+} CFG_DISPLAY;
+
+// Tipos de EEPROM 24Cxx suportados
+enum {
+    EE_24C32, EE_24C64, EE_24C128, EE_24C256, EE_24C512,
+    EE_24CM01, EE_24CM02,
+    EE_DETECTA              // descobre o tamanho na iniciação (24C32 a 24C512)
+};
+
+// Características de cada tipo
+// Todos usam endereço de 16 bits; nos 24CMxx os bits acima de 16
+// vão nos bits menos significativos do endereço I2C (seleção do bloco)
+typedef struct {
+    uint32_t tamanho;       // bytes
+    uint16_t pagina;        // bytes por página de gravação
+    uint8_t bitsBloco;      // bits de endereço no endereço I2C
+} EEPROM_TIPO;
+
+static constexpr EEPROM_TIPO EEPROM_TIPOS[] = {
+    {   4096,  32, 0 },     // 24C32
+    {   8192,  32, 0 },     // 24C64
+    {  16384,  64, 0 },     // 24C128
+    {  32768,  64, 0 },     // 24C256
+    {  65536, 128, 0 },     // 24C512
+    { 131072, 256, 1 },     // 24CM01
+    { 262144, 256, 2 },     // 24CM02
+};
+#define EE_MAX_PAGINA 256
+
+// EEPROM 24Cxx ligada a um I2C
+typedef struct {
+    uint8_t i2c;            // 0 = i2c0, 1 = i2c1
+    uint8_t sda, scl;
+    uint8_t endereco;       // endereço I2C (7 bits)
+    uint8_t tipo;           // EE_24C32 etc
+    uint32_t baud;
+} CFG_EEPROM;
+
+// Relê ligado a um GPIO
+typedef struct {
+    uint8_t pino;
+    bool ativoAlto;         // nível do pino com o relê acionado
+} CFG_RELE;
+
+// Rotary encoder com botão, lido por uma PIO
+typedef struct {
+    uint8_t pio;            // 0 = pio0, 1 = pio1
+    uint8_t a, b;           // fases (CLK e DT)
+    uint8_t sw;             // botão
+} CFG_ENCODER;
+
+// Placa do termostato
+struct PlacaTermostato {
+    static constexpr CFG_DISPLAY display = { 1, 14, 15, 18, 19, 20, 4000000 };
+    static constexpr CFG_EEPROM eeprom = { 1, 26, 27, 0x50, EE_24C32, 100000 };
+    static constexpr CFG_RELE rele = { 21, true };
+    static constexpr CFG_ENCODER encoder = { 0, 13, 12, 11 };
+
+    // Rede OneWire dos sensores
+    static constexpr uint8_t sensor = 10;
+
+    // Telemetria (UART dedicada, só transmissão)
+    static constexpr uint8_t telUart = 1;
+    static constexpr uint8_t telTx = 4;
+    static constexpr uint32_t telBaud = 921600;
+
+    // Aviso de falta de energia, ativo em nível baixo (-1 se não tem)
+    static constexpr int8_t avisoFalha = -1;
+};
+
+// Placa simulada no host: os mesmos periféricos, sem hardware
+struct PlacaHost {
+    static constexpr CFG_DISPLAY display = { 0, 0, 0, 0, 0, 0, 0 };
+    static constexpr CFG_EEPROM eeprom = { 0, 0, 0, 0x50, EE_24C32, 0 };
+    static constexpr CFG_RELE rele = { 0, true };
+    static constexpr CFG_ENCODER encoder = { 0, 0, 0, 0 };
+};
+
+// Placa para a qual estamos compilando
+#ifndef PLACA
+#define PLACA PlacaTermostato
+#endif
+
+#endif
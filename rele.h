@@ -0,0 +1,35 @@
+/**
+ * @file rele.h
+ * @author Daniel Quadros
+ * @brief Acionamento de um relê, especializado para as conexões da placa
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef RELE_H
+#define RELE_H
+
+#include "pico/stdlib.h"
+
+#include "placa.h"
+
+template <const CFG_RELE &cfg>
+class Rele {
+public:
+    // Inicia o pino já no estado desejado (evita um pulso no relê)
+    static void init(bool ligado) {
+        gpio_init(cfg.pino);
+        aciona(ligado);
+        gpio_set_dir(cfg.pino, true);
+    }
+
+    // Liga ou desliga o relê
+    static void aciona(bool ligado) {
+        gpio_put(cfg.pino, ligado == cfg.ativoAlto);
+    }
+};
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file retomada.cpp
+ * @author Daniel Quadros
+ * @brief Salvamento do estado do controle para retomada após reinício
+ *        pelo watchdog
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * O estado é salvo numa área de RAM que não é zerada na partida. Um
+ * reinício pelo watchdog preserva a RAM, uma falta de energia deixa
+ * lixo que é rejeitado pelo CRC.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "retomada.h"
+
+// Identificação, muda se o formato do estado mudar
+#define MAGICA  (0x52544D00u ^ (uint32_t) sizeof(ESTADO_CTL))
+
+static_assert(offsetof(CHECKPOINT, crc) == COPIA_CAB + sizeof(ESTADO_CTL),
+              "CHECKPOINT diferente do formato de copias.h");
+
+// Salva o estado na cópia mais antiga, seq é atualizado
+// A cópia é montada à parte e copiada de uma vez; um reinício no meio
+// da cópia deixa um CRC inválido e a outra cópia continua valendo
+void retomadaSalva (AREA_RETOMADA *area, uint32_t *seq, const ESTADO_CTL *est) {
+    CHECKPOINT novo;
+
+    copiaMonta ((uint8_t *) &novo, MAGICA, *seq + 1, est, sizeof(ESTADO_CTL));
+    memcpy (&area->copia[novo.seq & 1], &novo, sizeof(CHECKPOINT));
+    *seq = novo.seq;
+}
+
+// Recupera o estado mais recente válido, retorna false se não tiver
+bool retomadaRestaura (const AREA_RETOMADA *area, ESTADO_CTL *est, uint32_t *seq) {
+    bool valida[2];
+    uint32_t seqs[2];
+    for (int i = 0; i < 2; i++) {
+        valida[i] = copiaValida ((const uint8_t *) &area->copia[i], MAGICA, sizeof(ESTADO_CTL), &seqs[i]);
+    }
+    int melhor = copiaMaisRecente (valida, seqs);
+    if (melhor < 0) {
+        return false;
+    }
+    memcpy (est, &area->copia[melhor].estado, sizeof(ESTADO_CTL));
+    *seq = seqs[melhor];
+    return true;
+}
+
+// Invalida as duas cópias
+void retomadaInvalida (AREA_RETOMADA *area) {
+    memset (area, 0, sizeof(AREA_RETOMADA));
+}
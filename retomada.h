@@ -0,0 +1,56 @@
+/**
+ * @file retomada.h
+ * @author Daniel Quadros
+ * @brief Salvamento do estado do controle para retomada após reinício
+ *        pelo watchdog. Não depende do SDK.
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef RETOMADA_H
+#define RETOMADA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "controle.h"
+#include "copias.h"
+
+// Estado necessário para retomar o controle
+typedef struct {
+    int32_t temp;           // última temperatura (1/16 grau)
+    int tempLiga;           // set points (graus)
+    int tempDesliga;
+    bool ligado;            // estado do relê
+    uint32_t agora;         // instante do salvamento (ms)
+    int32_t relogio;        // segundo da semana pelo RTC (-1 se não acertado)
+    CONTROLE controle;
+} ESTADO_CTL;
+
+// Uma cópia do estado, no formato de copias.h
+typedef struct {
+    uint32_t magica;
+    uint32_t seq;
+    ESTADO_CTL estado;
+    uint32_t crc;
+} CHECKPOINT;
+
+// São mantidas duas cópias, gravadas alternadamente, para que um
+// reinício no meio de uma gravação não perca o estado anterior
+typedef struct {
+    CHECKPOINT copia[2];
+} AREA_RETOMADA;
+
+// Salva o estado na cópia mais antiga, seq é atualizado
+void retomadaSalva (AREA_RETOMADA *area, uint32_t *seq, const ESTADO_CTL *est);
+
+// Recupera o estado mais recente válido, retorna false se não tiver
+bool retomadaRestaura (const AREA_RETOMADA *area, ESTADO_CTL *est, uint32_t *seq);
+
+// Invalida as duas cópias
+void retomadaInvalida (AREA_RETOMADA *area);
+
+#endif
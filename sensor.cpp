@@ -10,6 +10,8 @@
  */
 
 #include <cstdio>
+#include <cstddef>
+#include <string.h>
 #include <math.h>
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
@@ -17,55 +19,214 @@
 #include "pico-onewire/api/one_wire.h"
 
 #include "picotermostato.h"
-
-static One_wire one_wire(PIN_SENSOR);
+#include "perifericos.h"
 
 #define MAX_SENSORES 3
-static int nSensores;
-static rom_address_t sensor[MAX_SENSORES];
 
-// Iniciação dos sensores
-void sensorInit () {
-	one_wire.init();
+// Tempo de conversão do DS18B20 (resolução de 12 bits)
+#define TEMPO_CONVERSAO_MS 750
+
+// Leituras seguidas sem nenhum sensor válido para considerar que
+// falta o sensor (cerca de 6 segundos)
+#define FALHAS_FALTA 8
+
+// Faixa de temperaturas válidas do DS18B20
+#define TEMP_MIN -55.0f
+#define TEMP_MAX 125.0f
+
+// Endereços dos sensores salvos na EEPROM, para não precisar
+// fazer a busca na rede a cada partida
+typedef struct {
+	uint8_t n;
+	rom_address_t end[MAX_SENSORES];
+	uint8_t chksum;
+} CACHE_ROM;
+
+// Estado de uma rede de sensores
+typedef struct {
+	One_wire *rede;
+	int nSensores;
+	rom_address_t sensor[MAX_SENSORES];
+
+	// Controle da validação dos endereços vindos da EEPROM
+	bool validar;		// primeira leitura ainda não feita
+	bool confirmar;		// falta confirmar com uma busca completa
+
+	// Última temperatura válida (para o caso de falha em todos os sensores)
+	int32_t ultimaTemp;
+	bool temLeitura;	// ultimaTemp é válida
+	int nFalhas;		// leituras seguidas sem nenhum sensor válido
+
+	// Última leitura de cada sensor (1/16 grau)
+	int32_t ultimaLeitura[MAX_SENSORES];
+} SENSORES;
+
+// O termostato tem uma única rede
+static One_wire one_wire(PLACA::sensor);
+static SENSORES sensores = { &one_wire };
+
+// Calcula o checksum do cache
+// (soma com deslocamento, para não aceitar EEPROM apagada)
+static uint8_t chkCache(CACHE_ROM *cache) {
+	uint8_t *p = (uint8_t *) cache;
+	uint8_t chk = 0xA5;
+	for (int i = 0; i < (int) offsetof(CACHE_ROM, chksum); i++) {
+		chk += p[i];
+	}
+	return chk;
+}
+
+// Le os endereços salvos na EEPROM
+static bool leCache(SENSORES *s) {
+	CACHE_ROM cache;
+	if (!EEPROM::read((uint8_t *) &cache, SENSOR_CACHE_ADDR, sizeof(cache)) ||
+		(cache.chksum != chkCache(&cache)) ||
+		(cache.n == 0) || (cache.n > MAX_SENSORES)) {
+		return false;
+	}
+	s->nSensores = cache.n;
+	memcpy (s->sensor, cache.end, sizeof(s->sensor));
+	return true;
+}
+
+// Salva os endereços na EEPROM
+static void salvaCache(SENSORES *s) {
+	CACHE_ROM cache;
+	memset (&cache, 0, sizeof(cache));
+	cache.n = s->nSensores;
+	memcpy (cache.end, s->sensor, sizeof(s->sensor));
+	cache.chksum = chkCache(&cache);
+	EEPROM::write((uint8_t *) &cache, SENSOR_CACHE_ADDR, sizeof(cache));
+}
 
-	int count = one_wire.find_and_count_devices_on_bus();
-	nSensores = 0;
+// Procura os sensores na rede
+// Retorna true se a lista mudou
+static bool buscaSensores(SENSORES *s) {
+	rom_address_t anterior[MAX_SENSORES];
+	int nAnterior = s->nSensores;
+	memcpy (anterior, s->sensor, sizeof(s->sensor));
+
+	int count = s->rede->find_and_count_devices_on_bus();
+	s->nSensores = 0;
 	for (int i = 0; i < count; i++) {
 		auto address = One_wire::get_address(i);
 		printf("Address: %02x%02x%02x%02x%02x%02x%02x%02x\r\n", address.rom[0], address.rom[1], address.rom[2],
 				address.rom[3], address.rom[4], address.rom[5], address.rom[6], address.rom[7]);
-		if ((address.rom[0] == FAMILY_CODE_DS18B20) && (nSensores < MAX_SENSORES)) {
-			sensor[nSensores] = address;
-			one_wire.convert_temperature(address, true, false);
-			printf("Temperature: %3.1foC\n", one_wire.temperature(address));
-			nSensores++;
+		if ((address.rom[0] == FAMILY_CODE_DS18B20) && (s->nSensores < MAX_SENSORES)) {
+			s->sensor[s->nSensores] = address;
+			s->nSensores++;
 		}
 	}
+	return (s->nSensores != nAnterior) ||
+		   (memcmp(anterior, s->sensor, s->nSensores*sizeof(rom_address_t)) != 0);
 }
 
-// Retorna a temperatura atual
-int sensorLe() {
-	// Trata o caso de nenhum sensor detectado
-	if (nSensores == 0) {
+// Iniciação dos sensores
+// Se rapido for true, usa os endereços salvos na EEPROM e deixa
+// a confirmação para as primeiras leituras
+void sensorInit (bool rapido) {
+	SENSORES *s = &sensores;
+	s->rede->init();
+
+	if (rapido && leCache(s)) {
+		s->validar = true;
+		return;
+	}
+	s->validar = s->confirmar = false;
+	if (buscaSensores(s)) {
+		salvaCache(s);
+	}
+}
+
+// Dispara a conversão e calcula a média das leituras válidas
+// Retorna o número de leituras válidas
+static int leSensores(SENSORES *s, float *media) {
+	if (s->nSensores == 0) {
+		// Mantém o ritmo das leituras, sem ocupar o core
+		energiaDorme(TEMPO_CONVERSAO_MS);
 		return 0;
 	}
 
-	// Dispara a leitura dos sensores
-	for (int i = 0; i < nSensores; i++) {
-		one_wire.convert_temperature(sensor[i], i == (nSensores-1), false);
+	// Dispara a leitura dos sensores e dorme durante a conversão
+	for (int i = 0; i < s->nSensores; i++) {
+		s->rede->convert_temperature(s->sensor[i], false, false);
 	}
+	energiaDorme(TEMPO_CONVERSAO_MS);
 	
-	// Le os resultados e retorna a média
+	// Le os resultados e calcula a média
 	float soma = 0.0f;
-	for (int i = 0; i < nSensores; i++) {
-		float leitura = one_wire.temperature(sensor[i]);
-		soma += leitura;
-		printf("Temperature: %3.1foC\n", leitura);
+	int nValidas = 0;
+	for (int i = 0; i < s->nSensores; i++) {
+		float leitura = s->rede->temperature(s->sensor[i]);
+		s->ultimaLeitura[i] = (int32_t) roundf(leitura*TEMP_ESCALA);
+		telSensor(i, s->ultimaLeitura[i]);
+		if ((leitura >= TEMP_MIN) && (leitura <= TEMP_MAX)) {
+			soma += leitura;
+			nValidas++;
+		}
+	}
+	if (nValidas > 0) {
+		*media = soma/nValidas;
 	}
-	return (int) roundf(soma/nSensores);
+	return nValidas;
 }
 
+// Retorna a temperatura atual, em 1/16 de grau
+int32_t sensorLe() {
+	SENSORES *s = &sensores;
+	float media;
+	int nValidas = leSensores(s, &media);
 
+	if (s->validar) {
+		// Endereços vieram da EEPROM
+		s->validar = false;
+		if (nValidas == s->nSensores) {
+			// Todos responderam, confirma com uma busca completa na
+			// próxima leitura, com o controle já funcionando
+			s->confirmar = true;
+		} else {
+			// Algum não respondeu, busca agora e lê de novo
+			if (buscaSensores(s)) {
+				salvaCache(s);
+			}
+			nValidas = leSensores(s, &media);
+		}
+	} else if (s->confirmar) {
+		s->confirmar = false;
+		if (buscaSensores(s)) {
+			printf("Sensores mudaram, atualizando EEPROM\n");
+			salvaCache(s);
+		}
+	} else if (s->nSensores == 0) {
+		// Sem sensores, procura de novo a cada leitura
+		if (buscaSensores(s)) {
+			printf("Sensores encontrados, atualizando EEPROM\n");
+			salvaCache(s);
+		}
+	}
 
+	if (nValidas > 0) {
+		s->ultimaTemp = (int32_t) roundf(media*TEMP_ESCALA);
+		s->temLeitura = true;
+		s->nFalhas = 0;
+	} else if (s->nFalhas < FALHAS_FALTA) {
+		s->nFalhas++;
+	}
+	return s->ultimaTemp;
+}
 
+// Retorna true se falta o sensor: nenhuma leitura válida desde a
+// partida ou nas últimas FALHAS_FALTA leituras
+// (o valor retornado por sensorLe não deve ser usado no controle)
+bool sensorFalta() {
+	return !sensores.temLeitura || (sensores.nFalhas >= FALHAS_FALTA);
+}
 
+// Retorna a última leitura de cada sensor, em 1/16 de grau
+int sensorUltimas(int32_t *temps, int max) {
+	int n = (sensores.nSensores < max)? sensores.nSensores : max;
+	for (int i = 0; i < n; i++) {
+		temps[i] = sensores.ultimaLeitura[i];
+	}
+	return n;
+}
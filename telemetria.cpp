@@ -0,0 +1,225 @@
+/**
+ * @file telemetria.cpp
+ * @author Daniel Quadros
+ * @brief Envio dos registros de telemetria
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Os registros são montados por quem os gera (qualquer um dos cores)
+ * e colocados numa fila circular. Na UART a transmissão é feita por
+ * DMA: o processador só coloca os registros na fila. Alternativamente
+ * (TELEMETRIA_USB) a fila é esvaziada na USB CDC pelo laço do core 0.
+ *
+ * O formato dos registros está descrito em telemetria.h
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/uart.h"
+#include "hardware/pio.h"
+#ifdef TELEMETRIA_USB
+#include "pico/stdio_usb.h"
+#endif
+
+#include "picotermostato.h"
+#include "placa.h"
+#include "telemetria.h"
+
+// Conexões da telemetria
+#define TEL_UART_ID   (PLACA::telUart ? uart1 : uart0)
+#define TEL_BAUD_RATE PLACA::telBaud
+#define PIN_TEL_TX    PLACA::telTx
+
+// Fila circular dos quadros a transmitir
+#define T_FILA_TEL 2048
+static uint8_t fila[T_FILA_TEL];
+static int poe, tira;
+static int emTransito;          // bytes sendo transmitidos pelo DMA
+static uint16_t perdidos;       // registros descartados por falta de espaço
+
+// Acesso à fila pelos dois cores e pela interrupção
+static critical_section critTel;
+
+// Canal de DMA
+static int dma_chan = -1;
+
+// Dispara a transmissão do trecho contínuo no início da fila
+// Chamar com critTel obtido
+static void disparaDMA() {
+#ifndef TELEMETRIA_USB
+    if ((emTransito == 0) && (poe != tira)) {
+        emTransito = (poe > tira) ? (poe - tira) : (T_FILA_TEL - tira);
+        dma_channel_transfer_from_buffer_now(dma_chan, &fila[tira], emTransito);
+    }
+#endif
+}
+
+// Libera o trecho transmitido
+// Chamar com critTel obtido
+static void liberaTrecho(int n) {
+    tira = (tira + n) % T_FILA_TEL;
+}
+
+#ifndef TELEMETRIA_USB
+// Esta rotina é executada quando o DMA termina a transferência
+static void dma_irq_handler() {
+    dma_hw->ints1 = 1u << dma_chan;
+    critical_section_enter_blocking(&critTel);
+    liberaTrecho(emTransito);
+    emTransito = 0;
+    disparaDMA();
+    critical_section_exit(&critTel);
+}
+#endif
+
+// Inicia a telemetria
+void telemetriaInit() {
+    critical_section_init(&critTel);
+    poe = tira = 0;
+    emTransito = 0;
+    perdidos = 0;
+
+#ifdef TELEMETRIA_USB
+    // O printf continua só na UART, a USB fica para a telemetria
+    stdio_set_driver_enabled(&stdio_usb, false);
+#else
+    // UART dedicada
+    uint baud = uart_init(TEL_UART_ID, TEL_BAUD_RATE);
+    printf ("Telemetria @ %u bps\n", baud);
+    gpio_set_function(PIN_TEL_TX, GPIO_FUNC_UART);
+
+    // DMA da fila para a UART, gera IRQ1 ao final
+    dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(TEL_UART_ID, true));
+    dma_channel_configure(dma_chan, &c, &uart_get_hw(TEL_UART_ID)->dr,
+                          fila, 0, false);
+    dma_channel_set_irq1_enabled(dma_chan, true);
+    irq_set_exclusive_handler(DMA_IRQ_1, dma_irq_handler);
+    irq_set_enabled(DMA_IRQ_1, true);
+#endif
+}
+
+// Esvazia a fila na USB (chamada no laço do core 0)
+void telemetriaPoll() {
+#ifdef TELEMETRIA_USB
+    while (true) {
+        critical_section_enter_blocking(&critTel);
+        int n = (poe >= tira) ? (poe - tira) : (T_FILA_TEL - tira);
+        int pos = tira;
+        critical_section_exit(&critTel);
+        if (n == 0) {
+            break;
+        }
+        // Só este laço tira da fila, o trecho não muda enquanto é enviado
+        stdio_usb.out_chars((const char *) &fila[pos], n);
+        critical_section_enter_blocking(&critTel);
+        liberaTrecho(n);
+        critical_section_exit(&critTel);
+    }
+#endif
+}
+
+// Coloca um registro na fila
+static void telEnvia(uint8_t tipo, const uint8_t *dados, int n) {
+    uint8_t quadro[TEL_MAX_QUADRO];
+    uint8_t aux[2];
+    int tam = telMonta(quadro, tipo, time_us_32(), dados, n);
+
+    critical_section_enter_blocking(&critTel);
+    int livre = T_FILA_TEL - 1 - ((poe - tira + T_FILA_TEL) % T_FILA_TEL);
+    if ((perdidos != 0) && (livre >= (tam + TEL_MAX_QUADRO))) {
+        // Avisa dos registros perdidos antes de retomar
+        aux[0] = (uint8_t) perdidos;
+        aux[1] = (uint8_t) (perdidos >> 8);
+        uint8_t qPerda[TEL_MAX_QUADRO];
+        int tPerda = telMonta(qPerda, TEL_PERDA, time_us_32(), aux, 2);
+        for (int i = 0; i < tPerda; i++) {
+            fila[poe] = qPerda[i];
+            poe = (poe + 1) % T_FILA_TEL;
+        }
+        livre -= tPerda;
+        perdidos = 0;
+    }
+    if ((perdidos == 0) && (livre >= tam)) {
+        for (int i = 0; i < tam; i++) {
+            fila[poe] = quadro[i];
+            poe = (poe + 1) % T_FILA_TEL;
+        }
+        disparaDMA();
+    } else if (perdidos < 0xFFFF) {
+        perdidos++;
+    }
+    critical_section_exit(&critTel);
+}
+
+// Coloca um valor de 16 bits nos dados
+static inline void poe16(uint8_t *p, int32_t val) {
+    p[0] = (uint8_t) val;
+    p[1] = (uint8_t) (val >> 8);
+}
+
+// Coloca um valor de 32 bits nos dados
+static inline void poe32(uint8_t *p, uint32_t val) {
+    p[0] = (uint8_t) val;
+    p[1] = (uint8_t) (val >> 8);
+    p[2] = (uint8_t) (val >> 16);
+    p[3] = (uint8_t) (val >> 24);
+}
+
+// Registros de telemetria
+
+void telTemperatura(int32_t temp, int saida, int modo) {
+    uint8_t dados[5];
+    poe16(dados, temp);
+    poe16(dados+2, saida);
+    dados[4] = (uint8_t) modo;
+    telEnvia(TEL_TEMP, dados, sizeof(dados));
+}
+
+void telSensor(int sensor, int32_t temp) {
+    uint8_t dados[3];
+    dados[0] = (uint8_t) sensor;
+    poe16(dados+1, temp);
+    telEnvia(TEL_SENSOR, dados, sizeof(dados));
+}
+
+void telRele(bool ligado) {
+    uint8_t dados = ligado ? 1 : 0;
+    telEnvia(TEL_RELE, &dados, 1);
+}
+
+void telPasso(uint32_t usLeitura, uint32_t usControle) {
+    uint8_t dados[8];
+    poe32(dados, usLeitura);
+    poe32(dados+4, usControle);
+    telEnvia(TEL_PASSO, dados, sizeof(dados));
+}
+
+void telTecla(int tecla) {
+    uint8_t dados = (uint8_t) tecla;
+    telEnvia(TEL_TECLA, &dados, 1);
+}
+
+void telConfig(int liga, int desliga) {
+    uint8_t dados[2];
+    dados[0] = (uint8_t) liga;
+    dados[1] = (uint8_t) desliga;
+    telEnvia(TEL_CONFIG, dados, sizeof(dados));
+}
+
+void telAgenda(int liga, int desliga) {
+    uint8_t dados[2];
+    dados[0] = (uint8_t) liga;
+    dados[1] = (uint8_t) desliga;
+    telEnvia(TEL_AGENDA, dados, sizeof(dados));
+}
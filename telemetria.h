@@ -0,0 +1,53 @@
+/**
+ * @file telemetria.h
+ * @author Daniel Quadros
+ * @brief Formato dos registros de telemetria
+ *        Compartilhado entre o firmware e o decodificador no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Cada registro é composto por:
+ *   tipo (1 byte), instante em us (4 bytes), dados, CRC-8 (1 byte)
+ * Os valores com mais de um byte são little-endian.
+ * O registro é codificado com COBS e terminado por um byte zero, o
+ * que permite ressincronizar em qualquer ponto da transmissão.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tipos de registro e seus dados
+#define TEL_TEMP     1      // temp média int16 (1/16 grau), saída PID uint16, modo uint8
+#define TEL_SENSOR   2      // sensor uint8, temp int16 (1/16 grau)
+#define TEL_RELE     3      // estado uint8
+#define TEL_PASSO    4      // leitura uint32 (us), controle uint32 (us)
+#define TEL_TECLA    5      // tecla uint8
+#define TEL_CONFIG   6      // liga int8, desliga int8 (configuração salva)
+#define TEL_PERDA    7      // registros descartados uint16
+#define TEL_AGENDA   8      // liga int8, desliga int8 (transição da agenda)
+
+#define TEL_MAX_DADOS   16                      // tamanho máximo dos dados
+#define TEL_MAX_REG     (1+4+TEL_MAX_DADOS+1)   // tamanho máximo do registro
+#define TEL_MAX_QUADRO  (TEL_MAX_REG+2)         // após COBS, com o terminador
+
+// Monta um registro codificado e terminado, retorna o tamanho
+int telMonta (uint8_t *quadro, uint8_t tipo, uint32_t tempo, const uint8_t *dados, int n);
+
+// Decodifica um quadro (sem o terminador)
+// Retorna o tamanho do registro ou -1 se inválido
+int telDecodifica (uint8_t *reg, const uint8_t *quadro, int n);
+
+// Codificação COBS
+int cobsCodifica (uint8_t *dest, const uint8_t *orig, int n);
+int cobsDecodifica (uint8_t *dest, const uint8_t *orig, int n);
+
+// CRC-8 (polinômio 0x07)
+uint8_t crc8 (const uint8_t *p, int n);
+
+#endif
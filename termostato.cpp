@@ -0,0 +1,65 @@
+/**
+ * @file termostato.cpp
+ * @author Daniel Quadros
+ * @brief Estado de um termostato (set points, relê e controle)
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Todo o estado fica na estrutura TERMOSTATO, permitindo simular
+ * vários termostatos independentes no host. No firmware existe uma
+ * única instância, em picotermostato.cpp.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "termostato.h"
+
+// Inicia o termostato, com o relê desligado
+void termostatoInit (TERMOSTATO *termo, int modo, int liga, int desliga) {
+    memset (termo, 0, sizeof(TERMOSTATO));
+    controleInit (&termo->controle, modo);
+    termo->tempLiga = liga;
+    termo->tempDesliga = desliga;
+    termo->ligado = false;
+    termo->pedidoModo = -1;
+}
+
+// Pede uma mudança de modo, aplicada no próximo passo
+void termostatoPedeModo (TERMOSTATO *termo, int modo) {
+    termo->pedidoModo = modo;
+}
+
+// Executa um passo com uma nova temperatura (1/16 grau)
+// Retorna true se o relê deve mudar de estado (termo->ligado já atualizado)
+bool termostatoPasso (TERMOSTATO *termo, int32_t temp, uint32_t agora) {
+    termo->temp = temp;
+    if (termo->pedidoModo >= 0) {
+        controleModo (&termo->controle, termo->pedidoModo);
+        termo->pedidoModo = -1;
+    }
+    controleSetPoints (&termo->controle, termo->tempLiga, termo->tempDesliga);
+    bool ligar = controlePasso (&termo->controle, temp, agora);
+    termo->nPassos++;
+    if (ligar == termo->ligado) {
+        return false;
+    }
+    termo->ligado = ligar;
+    termo->nTrocas++;
+    return true;
+}
+
+// Executa um passo sem temperatura (falta de sensor)
+// O pedido de modo fica pendente até voltar a ter temperatura
+bool termostatoSemSensor (TERMOSTATO *termo, uint32_t agora) {
+    controleDesliga (&termo->controle, agora);
+    termo->nPassos++;
+    if (!termo->ligado) {
+        return false;
+    }
+    termo->ligado = false;
+    termo->nTrocas++;
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file termostato.h
+ * @author Daniel Quadros
+ * @brief Estado de um termostato (set points, relê e controle)
+ *        Não depende do SDK, para poder ter várias instâncias no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef TERMOSTATO_H
+#define TERMOSTATO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "controle.h"
+
+// Um termostato
+// Os set points e o pedido de modo são alterados pela interface com
+// o operador; o restante só pelo passo do controle
+typedef struct {
+    CONTROLE controle;
+    int tempLiga;           // set points (graus)
+    int tempDesliga;
+    bool ligado;            // estado do relê
+    int32_t temp;           // última temperatura (1/16 grau)
+    int pedidoModo;         // mudança de modo pendente (-1 se nenhuma)
+    uint32_t nTrocas;       // trocas do relê
+    uint32_t nPassos;       // passos do controle
+} TERMOSTATO;
+
+// Inicia o termostato, com o relê desligado
+void termostatoInit (TERMOSTATO *termo, int modo, int liga, int desliga);
+
+// Pede uma mudança de modo, aplicada no próximo passo
+void termostatoPedeModo (TERMOSTATO *termo, int modo);
+
+// Executa um passo com uma nova temperatura (1/16 grau)
+// Retorna true se o relê deve mudar de estado (termo->ligado já atualizado)
+bool termostatoPasso (TERMOSTATO *termo, int32_t temp, uint32_t agora);
+
+// Executa um passo sem temperatura (falta de sensor): o controle não
+// é executado e o relê fica desligado
+// Retorna true se o relê deve mudar de estado (termo->ligado já atualizado)
+bool termostatoSemSensor (TERMOSTATO *termo, uint32_t agora);
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file uso.cpp
+ * @author Daniel Quadros
+ * @brief Contabilização do uso do relê
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Os totais são gravados na EEPROM em cópias alternadas (copias.h),
+ * com USO_TOTAL como dados.
+ *
+ * Os instantes são em ms desde a partida, em 32 bits; as comparações
+ * são feitas pela diferença, para funcionar na volta do contador.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#include <string.h>
+
+#include "uso.h"
+#include "copias.h"
+
+// Identificação das cópias dos totais
+#define MAGICA  0x55534F21u
+
+static_assert(COPIA_TAM(sizeof(USO_TOTAL)) <= USO_TAM_COPIA, "USO_TOTAL grande demais para USO_TAM_COPIA");
+
+// Inicia a contabilização, partindo dos totais indicados
+void usoInit (USO *u, const USO_TOTAL *total, bool ligado, uint32_t agora) {
+    memset (u, 0, sizeof(USO));
+    u->total = *total;
+    u->ligado = ligado;
+    u->tConta = agora;
+    u->tFimHora = agora + USO_HORA_MS;
+}
+
+// Soma aos totais os indicados (lidos da EEPROM depois de iniciar,
+// numa retomada)
+void usoSomaTotal (USO *u, const USO_TOTAL *total) {
+    u->total.segLigado += total->segLigado;
+    u->total.segContado += total->segContado;
+    u->total.ciclos += total->ciclos;
+    u->total.curtos += total->curtos;
+}
+
+// Acumula o tempo ligado até o instante indicado
+static void acumula (USO *u, uint32_t ate) {
+    if (u->ligado) {
+        u->msHora += ate - u->tConta;
+    }
+    u->tConta = ate;
+}
+
+// Fecha o dia atual, colocando no anel dos dias
+static void fechaDia (USO *u) {
+    if (u->nDias == USO_DIAS) {
+        u->somaSegDias -= u->segDias[u->iDia];
+    } else {
+        u->nDias++;
+    }
+    u->segDias[u->iDia] = u->segDia;
+    u->somaSegDias += u->segDia;
+    u->iDia = (u->iDia + 1) % USO_DIAS;
+    u->segDia = 0;
+    u->horasDia = 0;
+}
+
+// Fecha a hora atual, colocando no anel das horas e nos totais
+static void fechaHora (USO *u) {
+    uint32_t seg = u->msHora / 1000;
+    u->msHora %= 1000;          // o resto passa para a hora seguinte
+
+    if (u->nHoras == USO_HORAS) {
+        u->somaSegHoras -= u->segHoras[u->iHora];
+        u->somaCiclosHoras -= u->ciclosHoras[u->iHora];
+        u->somaCurtosHoras -= u->curtosHoras[u->iHora];
+    } else {
+        u->nHoras++;
+    }
+    u->segHoras[u->iHora] = (uint16_t) seg;
+    u->ciclosHoras[u->iHora] = u->ciclosHora;
+    u->curtosHoras[u->iHora] = u->curtosHora;
+    u->somaSegHoras += seg;
+    u->somaCiclosHoras += u->ciclosHora;
+    u->somaCurtosHoras += u->curtosHora;
+    u->iHora = (u->iHora + 1) % USO_HORAS;
+
+    u->total.segLigado += seg;
+    u->total.segContado += USO_HORA_MS / 1000;
+    u->total.ciclos += u->ciclosHora;
+    u->total.curtos += u->curtosHora;
+    u->ciclosHora = 0;
+    u->curtosHora = 0;
+
+    u->segDia += seg;
+    if (++u->horasDia == 24) {
+        fechaDia (u);
+    }
+}
+
+// Avança o tempo, fechando as horas que terminaram
+// Normalmente fecha no máximo uma hora por chamada
+bool usoPoll (USO *u, uint32_t agora) {
+    bool fechou = false;
+    while ((int32_t) (agora - u->tFimHora) >= 0) {
+        acumula (u, u->tFimHora);
+        fechaHora (u);
+        u->tFimHora += USO_HORA_MS;
+        fechou = true;
+    }
+    acumula (u, agora);
+    if (fechou) {
+        u->gravar = true;
+    }
+    return fechou;
+}
+
+// Registra uma troca do relê
+// Um ciclo é medido de uma ligada até a seguinte
+void usoTroca (USO *u, bool ligado, uint32_t agora) {
+    usoPoll (u, agora);
+    if (ligado == u->ligado) {
+        return;
+    }
+    if (ligado) {
+        u->ciclosHora++;
+        if (u->ligou) {
+            u->ultimoCiclo = agora - u->tLigou;
+            if (u->ultimoCiclo < USO_CICLO_CURTO_MS) {
+                u->curtosHora++;
+            }
+        }
+        u->ligou = true;
+        u->tLigou = agora;
+    }
+    u->ligado = ligado;
+}
+
+// Tempo ligado na hora atual, até agora (ms)
+static uint32_t msLigadoHora (const USO *u, uint32_t agora) {
+    return u->msHora + (u->ligado ? agora - u->tConta : 0);
+}
+
+// Totais incluindo a hora em andamento
+void usoTotal (const USO *u, uint32_t agora, USO_TOTAL *total) {
+    *total = u->total;
+    total->segLigado += msLigadoHora (u, agora) / 1000;
+    total->segContado += (agora - (u->tFimHora - USO_HORA_MS)) / 1000;
+    total->ciclos += u->ciclosHora;
+    total->curtos += u->curtosHora;
+}
+
+// Resumo para apresentação
+void usoResumo (const USO *u, uint32_t agora, USO_RESUMO *res) {
+    usoTotal (u, agora, &res->total);
+
+    uint32_t decorrido = agora - (u->tFimHora - USO_HORA_MS);
+    res->cicloHora = (decorrido == 0) ? 0 :
+                     (uint16_t) (((uint64_t) msLigadoHora (u, agora) * 1000) / decorrido);
+    res->nHoras = u->nHoras;
+    res->ciclo24h = (u->nHoras == 0) ? res->cicloHora :
+                    (uint16_t) ((u->somaSegHoras * 1000) / (u->nHoras * 3600u));
+    res->nDias = u->nDias;
+    res->cicloDias = (u->nDias == 0) ? res->ciclo24h :
+                     (uint16_t) ((u->somaSegDias * 1000) / (u->nDias * 86400u));
+    res->ciclos24h = u->somaCiclosHoras + u->ciclosHora;
+    res->curtos24h = u->somaCurtosHoras + u->curtosHora;
+    res->ultimoCiclo = u->ultimoCiclo;
+
+    int anterior = (u->iHora + USO_HORAS - 1) % USO_HORAS;
+    res->alerta = (u->curtosHora >= USO_ALERTA_CURTOS) ||
+                  ((u->nHoras > 0) && (u->curtosHoras[anterior] >= USO_ALERTA_CURTOS));
+}
+
+// Lê os totais da cópia mais recente válida
+bool usoCarrega (USO_TOTAL *total, uint32_t base, uint32_t *seq) {
+    memset (total, 0, sizeof(USO_TOTAL));
+    return copiasCarrega (MAGICA, total, sizeof(USO_TOTAL), base, USO_TAM_COPIA, seq);
+}
+
+// Grava os totais na cópia mais antiga, seq é atualizado
+// Se a gravação falhar, a próxima tentativa usa a mesma cópia
+bool usoGrava (const USO_TOTAL *total, uint32_t base, uint32_t *seq) {
+    return copiasGrava (MAGICA, total, sizeof(USO_TOTAL), base, USO_TAM_COPIA, seq);
+}
@@ -0,0 +1,138 @@
+/**
+ * @file uso.h
+ * @author Daniel Quadros
+ * @brief Contabilização do uso do relê (tempo ligado, ciclos, ciclo de
+ *        trabalho por hora e por dia, ciclos curtos)
+ *        Não depende do SDK, é usado também no host
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * Cada troca do relê e cada passo do controle atualizam os contadores
+ * em tempo constante: o tempo ligado é acumulado na hora atual e, ao
+ * fechar uma hora, ela entra num anel com as últimas USO_HORAS horas
+ * (e no dia atual, que entra num anel com os últimos USO_DIAS dias).
+ * As somas dos anéis são mantidas junto, somando o valor que entra e
+ * subtraindo o que sai, de modo que o ciclo de trabalho das últimas
+ * 24 horas ou dos últimos dias não exige percorrer os anéis.
+ *
+ * As horas são contadas a partir da partida (não há relógio).
+ *
+ * Os totais (tempo ligado, tempo contado, ciclos e ciclos curtos) são
+ * gravados na EEPROM em duas cópias alternadas, com CRC, a cada hora
+ * fechada e num aviso de falta de energia. Num reinício perde-se no
+ * máximo a hora em andamento.
+ *
+ * @copyright Copyright (c) 2022, Daniel Quadros
+ *
+ */
+
+#ifndef USO_H
+#define USO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define USO_HORAS   24          // horas no anel
+#define USO_DIAS    7           // dias no anel
+#define USO_HORA_MS 3600000u
+
+// Um ciclo (de uma ligada até a seguinte) mais curto que isto é
+// considerado curto (a janela do PID é de 5 minutos, com tempos mínimos
+// de 1 minuto ligado e desligado); USO_ALERTA_CURTOS ciclos curtos na
+// mesma hora geram o alerta
+#define USO_CICLO_CURTO_MS  (3u*60u*1000u)
+#define USO_ALERTA_CURTOS   3
+
+#define USO_TAM_COPIA   32      // espaço de cada cópia na EEPROM
+
+// Totais preservados na EEPROM
+typedef struct {
+    uint32_t segLigado;     // tempo com o relê ligado (s)
+    uint32_t segContado;    // tempo contabilizado (s)
+    uint32_t ciclos;        // vezes que o relê ligou
+    uint32_t curtos;        // ciclos curtos
+} USO_TOTAL;
+
+// Estado da contabilização
+typedef struct {
+    bool ligado;            // estado atual do relê
+    uint32_t tConta;        // instante até onde já foi contabilizado (ms)
+    uint32_t tFimHora;      // fim da hora atual (ms)
+    bool ligou;             // tLigou é válido
+    uint32_t tLigou;        // instante da última ligada (ms)
+    uint32_t ultimoCiclo;   // duração do último ciclo completo (ms)
+
+    // Hora atual
+    uint32_t msHora;        // tempo ligado (ms)
+    uint16_t ciclosHora;
+    uint16_t curtosHora;
+
+    // Últimas horas fechadas
+    uint16_t segHoras[USO_HORAS];
+    uint16_t ciclosHoras[USO_HORAS];
+    uint16_t curtosHoras[USO_HORAS];
+    int iHora;              // próxima posição a ocupar
+    int nHoras;             // posições ocupadas
+    uint32_t somaSegHoras;  // somas das posições ocupadas
+    uint32_t somaCiclosHoras;
+    uint32_t somaCurtosHoras;
+
+    // Dia atual e últimos dias fechados
+    uint32_t segDia;
+    int horasDia;           // horas fechadas no dia atual
+    uint32_t segDias[USO_DIAS];
+    int iDia;
+    int nDias;
+    uint32_t somaSegDias;
+
+    USO_TOTAL total;        // totais até a última hora fechada
+    bool gravar;            // fechou uma hora, os totais devem ser gravados
+} USO;
+
+// Resumo para apresentação (ciclos de trabalho em 0,1%)
+typedef struct {
+    USO_TOTAL total;        // incluindo a hora atual
+    uint16_t cicloHora;     // hora atual
+    uint16_t ciclo24h;      // horas fechadas no anel (hora atual se nenhuma)
+    uint16_t cicloDias;     // dias fechados no anel (24h se nenhum)
+    int nHoras;             // horas e dias considerados
+    int nDias;
+    uint32_t ciclos24h;     // ciclos nas horas do anel mais a atual
+    uint32_t curtos24h;
+    uint32_t ultimoCiclo;   // duração do último ciclo (ms, 0 se nenhum)
+    bool alerta;            // ciclos curtos demais na hora atual ou na anterior
+} USO_RESUMO;
+
+// Funções fornecidas pela aplicação para acesso à EEPROM
+// (as mesmas usadas pela configuração)
+bool appEepromLe (uint8_t *buffer, uint32_t addr, int n);
+bool appEepromGrava (const uint8_t *buffer, uint32_t addr, int n);
+
+// Inicia a contabilização, partindo dos totais indicados
+void usoInit (USO *u, const USO_TOTAL *total, bool ligado, uint32_t agora);
+
+// Soma aos totais os indicados (lidos da EEPROM depois de iniciar,
+// numa retomada)
+void usoSomaTotal (USO *u, const USO_TOTAL *total);
+
+// Registra uma troca do relê
+void usoTroca (USO *u, bool ligado, uint32_t agora);
+
+// Avança o tempo (chamar a cada passo do controle)
+// Retorna true se fechou alguma hora (u->gravar fica true)
+bool usoPoll (USO *u, uint32_t agora);
+
+// Totais incluindo a hora em andamento
+void usoTotal (const USO *u, uint32_t agora, USO_TOTAL *total);
+
+// Resumo para apresentação
+void usoResumo (const USO *u, uint32_t agora, USO_RESUMO *res);
+
+// Lê os totais da cópia mais recente válida em base e base+USO_TAM_COPIA
+// Retorna false (e totais zerados) se não tiver nenhuma
+bool usoCarrega (USO_TOTAL *total, uint32_t base, uint32_t *seq);
+
+// Grava os totais na cópia mais antiga, seq é atualizado
+bool usoGrava (const USO_TOTAL *total, uint32_t base, uint32_t *seq);
+
+#endif